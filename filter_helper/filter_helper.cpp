@@ -8,10 +8,40 @@
 #include <iostream>
 #include <algorithm>
 #include <cctype>
-#include <unordered_set>
+#include <cstring>
+#include <iomanip>
 
 #include "filter_helper.hpp"
 
+std::atomic<uint32_t> filter_generation{1};
+
+static std::atomic<uint64_t> cache_hits_total{0};
+static std::atomic<uint64_t> cache_misses_total{0};
+
+// Hash only picks the entry quickly, name is compared too so crafted FNV collisions cannot hit
+struct verdict_cache_entry {
+    uint64_t hash = 0;
+    uint32_t generation = 0; // 0 = empty
+    bool blocked = false;
+    uint8_t length = 0;
+    char name[VERDICT_CACHE_NAME];
+};
+
+// Direct-mapped set of two ways, owned by single worker so no locking needed
+struct verdict_cache {
+    verdict_cache_entry ways[VERDICT_CACHE_SETS][2];
+    uint8_t victim[VERDICT_CACHE_SETS] = {};
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    ~verdict_cache() {
+        cache_hits_total += hits;
+        cache_misses_total += misses;
+    }
+};
+
+static thread_local verdict_cache cache;
+
 // Trim leading/trailing whitespace
 static inline void trim(std::string &line) {
     size_t start = line.find_first_not_of(" \t\r\n");
@@ -82,16 +112,152 @@ static bool validate_domain(const std::string &domain) {
     return true;
 }
 
+// FNV-1a 64-bit
+static inline uint64_t hash_domain(std::string_view domain) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : domain) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Mix parent node into label hash so equal labels under different parents spread
+static inline uint64_t hash_node(uint32_t parent, uint64_t label_hash) {
+    uint64_t hash = (label_hash ^ parent) * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 32);
+}
+
+static inline std::string_view label_at(const filter_set &rules, uint32_t offset) {
+    return std::string_view(&rules.labels[offset + 1], static_cast<uint8_t>(rules.labels[offset]));
+}
+
+// Child of parent with given label, 0 if there is none
+static uint32_t find_node(const filter_set &rules, uint32_t parent, std::string_view label, uint64_t label_hash) {
+    size_t mask = rules.index.size() - 1;
+    for (size_t slot = hash_node(parent, label_hash) & mask;; slot = (slot + 1) & mask) {
+        uint32_t node = rules.index[slot];
+        if (node == 0) return 0;
+        if (rules.nodes[node].parent == parent && label_at(rules, rules.nodes[node].label) == label) return node;
+    }
+}
+
+static void index_node(filter_set &rules, uint32_t node) {
+    const filter_node &entry = rules.nodes[node];
+    size_t mask = rules.index.size() - 1;
+    size_t slot = hash_node(entry.parent, hash_domain(label_at(rules, entry.label))) & mask;
+    while (rules.index[slot] != 0) slot = (slot + 1) & mask;
+    rules.index[slot] = node;
+}
+
+static uint32_t add_node(filter_set &rules, uint32_t parent, uint32_t label) {
+    // Keep load factor under 3/4, table size stays power of two
+    if ((rules.nodes.size() + 1) * 4 > rules.index.size() * 3) {
+        rules.index.assign(rules.index.size() * 2, 0);
+        for (uint32_t node = 1; node < rules.nodes.size(); ++node) index_node(rules, node);
+    }
+
+    uint32_t node = rules.nodes.size();
+    rules.nodes.push_back({parent, label});
+    rules.blocked.push_back(false);
+    index_node(rules, node);
+    return node;
+}
+
+// Label dictionary, needed only while loading so every distinct label is stored once in arena
+struct label_dictionary {
+    std::vector<uint32_t> index = std::vector<uint32_t>(1024, 0); // Arena offsets, 0 = empty
+    size_t count = 0;
+};
+
+static uint32_t intern_label(filter_set &rules, label_dictionary &dict, std::string_view label, uint64_t hash) {
+    size_t mask = dict.index.size() - 1;
+    size_t slot = hash & mask;
+    for (; dict.index[slot] != 0; slot = (slot + 1) & mask) {
+        if (label_at(rules, dict.index[slot]) == label) return dict.index[slot];
+    }
+
+    uint32_t offset = rules.labels.size();
+    rules.labels.push_back(static_cast<char>(label.size()));
+    rules.labels.insert(rules.labels.end(), label.begin(), label.end());
+    dict.index[slot] = offset;
+
+    if (++dict.count * 4 > dict.index.size() * 3) {
+        std::vector<uint32_t> old = std::move(dict.index);
+        dict.index.assign(old.size() * 2, 0);
+        mask = dict.index.size() - 1;
+        for (uint32_t entry : old) {
+            if (entry == 0) continue;
+            size_t pos = hash_domain(label_at(rules, entry)) & mask;
+            while (dict.index[pos] != 0) pos = (pos + 1) & mask;
+            dict.index[pos] = entry;
+        }
+    }
+    return offset;
+}
+
+// Walk labels from TLD down, creating missing nodes
+static void insert_rule(filter_set &rules, label_dictionary &dict, std::string_view domain) {
+    uint32_t parent = 0;
+    size_t end = domain.size();
+
+    while (true) {
+        size_t dot = domain.rfind('.', end - 1);
+        size_t start = (dot == std::string_view::npos) ? 0 : dot + 1;
+        std::string_view label = domain.substr(start, end - start);
+        uint64_t hash = hash_domain(label);
+
+        uint32_t node = find_node(rules, parent, label, hash);
+        if (node == 0) node = add_node(rules, parent, intern_label(rules, dict, label, hash));
+        parent = node;
+
+        // Leading dot would wrap rfind() around, validated rules never have one
+        if (dot == std::string_view::npos || dot == 0) break;
+        end = dot;
+    }
+
+    if (!rules.blocked[parent]) {
+        rules.blocked[parent] = true;
+        rules.rules++;
+    }
+}
+
+size_t filter_set_bytes(const filter_set &rules) {
+    return rules.labels.capacity()
+         + rules.nodes.capacity() * sizeof(filter_node)
+         + rules.index.capacity() * sizeof(uint32_t)
+         + rules.blocked.capacity() / 8;
+}
+
+void for_each_rule(const filter_set &rules, const std::function<void(std::string_view)> &fn) {
+    std::string domain;
+    for (uint32_t node = 1; node < rules.nodes.size(); ++node) {
+        if (!rules.blocked[node]) continue;
+
+        domain.clear();
+        for (uint32_t current = node; current != 0; current = rules.nodes[current].parent) {
+            if (!domain.empty()) domain += '.';
+            domain += label_at(rules, rules.nodes[current].label);
+        }
+        fn(domain);
+    }
+}
+
 // Load domain blocklist from file
-std::unordered_set<std::string> load_filters(const std::string &filename, bool verbose) {
+filter_set load_filters(const std::string &filename, bool verbose) {
     std::ifstream file(filename);
-    std::unordered_set<std::string> rules;
+    filter_set rules;
+    rules.labels.push_back(0);         // Offset 0 marks empty dictionary slot
+    rules.nodes.push_back({0, 0});     // Root
+    rules.blocked.push_back(false);
+    rules.index.assign(1024, 0);
 
     if (!file.is_open()) {
         std::cerr << "ERROR: Cannot open file '" << filename << "'\n";
         return rules;
     }
 
+    label_dictionary dict;
     std::string line;
     size_t lineno = 0;
 
@@ -113,28 +279,90 @@ std::unordered_set<std::string> load_filters(const std::string &filename, bool v
             continue;
         }
 
-        rules.insert(domain);
+        insert_rule(rules, dict, domain);
     }
 
+    rules.labels.shrink_to_fit();
+    rules.nodes.shrink_to_fit();
+    rules.blocked.shrink_to_fit();
+    filter_generation++;
+
     if (verbose) {
-        std::cout << "Loaded " << rules.size() << " filter rules\n";
+        size_t bytes = filter_set_bytes(rules);
+        std::cout << "Loaded " << rules.rules << " filter rules\n";
+        std::cout << "Filter storage: " << bytes / 1024 << " KiB, " << dict.count << " labels, "
+                  << rules.nodes.size() - 1 << " nodes, " << std::fixed << std::setprecision(1)
+                  << (rules.rules ? static_cast<double>(bytes) / rules.rules : 0.0) << " bytes per rule\n";
+        std::cout.unsetf(std::ios::floatfield);
         std::cout << "==========================================\n";
     }
 
     return rules;
 }
 
-// Check if domain is blocked by matching exact or suffix
-bool is_blocked(std::string_view domain, const std::unordered_set<std::string> &rules) {
-    for (const auto &rule : rules) {
-        if (domain == rule)
-            return true;
-        if (domain.size() > rule.size() &&
-            domain.compare(domain.size() - rule.size(), rule.size(), rule) == 0 &&
-            domain[domain.size() - rule.size() - 1] == '.') {
-            return true;
+// Check if domain is blocked by matching exact or suffix, one table probe per label
+bool is_blocked(std::string_view domain, const filter_set &rules) {
+    if (domain.empty()) return false;
+
+    uint32_t parent = 0;
+    size_t end = domain.size();
+
+    while (true) {
+        size_t dot = domain.rfind('.', end - 1);
+        size_t start = (dot == std::string_view::npos) ? 0 : dot + 1;
+        std::string_view label = domain.substr(start, end - start);
+
+        uint32_t node = find_node(rules, parent, label, hash_domain(label));
+        if (node == 0) return false;
+        if (rules.blocked[node]) return true;
+        parent = node;
+
+        // Leading dot comes from label containing 0x2E byte, empty label matches no rule
+        if (dot == std::string_view::npos || dot == 0) return false;
+        end = dot;
+    }
+}
+
+bool is_blocked_cached(std::string_view domain, const filter_set &rules) {
+    if (domain.size() > VERDICT_CACHE_NAME) {
+        cache.misses++;
+        return is_blocked(domain, rules);
+    }
+
+    uint64_t hash = hash_domain(domain);
+    uint32_t generation = filter_generation.load(std::memory_order_relaxed);
+    size_t set = hash % VERDICT_CACHE_SETS;
+    verdict_cache_entry* ways = cache.ways[set];
+
+    for (int way = 0; way < 2; ++way) {
+        verdict_cache_entry &entry = ways[way];
+        if (entry.generation == generation && entry.hash == hash &&
+            std::string_view(entry.name, entry.length) == domain) {
+            cache.hits++;
+            cache.victim[set] = 1 - way; // Keep most recently used way
+            return entry.blocked;
         }
     }
-    return false;
+
+    cache.misses++;
+    bool blocked = is_blocked(domain, rules);
+
+    uint8_t way = cache.victim[set];
+    ways[way].hash = hash;
+    ways[way].generation = generation;
+    ways[way].blocked = blocked;
+    ways[way].length = domain.size();
+    memcpy(ways[way].name, domain.data(), domain.size());
+    cache.victim[set] = 1 - way;
+
+    return blocked;
 }
 
+// Totals are collected when worker threads exit
+void print_verdict_cache_stats() {
+    uint64_t hits = cache_hits_total.load();
+    uint64_t lookups = hits + cache_misses_total.load();
+    double rate = lookups ? 100.0 * hits / lookups : 0.0;
+    std::cout << "Verdict cache: " << hits << "/" << lookups << " hits ("
+              << std::fixed << std::setprecision(1) << rate << "%)\n";
+}
@@ -7,9 +7,45 @@
 #pragma once
 
 #include <string>
-#include <unordered_set>
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <string_view>
 
-std::unordered_set<std::string> load_filters(const std::string &filename, bool verbose);
+constexpr size_t VERDICT_CACHE_SETS = 2048; // 2-way, per worker thread
+constexpr size_t VERDICT_CACHE_NAME = 64;   // Longer names bypass the cache
 
-bool is_blocked(std::string_view domain, const std::unordered_set<std::string>& rules);
+// Domain as child of its parent domain, "ads.example.com" is node "ads" under node "example" under "com"
+struct filter_node {
+    uint32_t parent; // Node index, 0 = root
+    uint32_t label;  // Offset of interned label in label arena
+};
+
+// Filter rules as tree of interned labels, shared suffixes are stored once
+struct filter_set {
+    std::vector<char> labels;          // Arena of distinct labels, each prefixed by its length
+    std::vector<filter_node> nodes;    // Node 0 is root
+    std::vector<uint32_t> index;       // Open addressing (parent, label) -> node, 0 = empty
+    std::vector<bool> blocked;         // Node is a rule itself
+    size_t rules = 0;
+};
+
+// Bumped whenever filter set changes, invalidates all verdict cache entries
+extern std::atomic<uint32_t> filter_generation;
+
+filter_set load_filters(const std::string &filename, bool verbose);
+
+// Call fn with every rule in dotted form
+void for_each_rule(const filter_set& rules, const std::function<void(std::string_view)>& fn);
+
+// Resident size of all filter_set buffers in bytes
+size_t filter_set_bytes(const filter_set& rules);
+
+bool is_blocked(std::string_view domain, const filter_set& rules);
+
+// is_blocked() memoized in per-thread cache, entries hold the whole (lowercase) domain
+bool is_blocked_cached(std::string_view domain, const filter_set& rules);
+
+void print_verdict_cache_stats();
 
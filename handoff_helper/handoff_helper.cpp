@@ -0,0 +1,234 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <iostream>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "handoff_helper.hpp"
+
+volatile sig_atomic_t reexec_requested = 0;
+static std::atomic<bool> completed{false};
+
+constexpr uint8_t HANDOFF_HAS_IPV4 = 0x01;
+constexpr uint8_t HANDOFF_HAS_IPV6 = 0x02;
+constexpr char HANDOFF_READY = 'R';
+
+static bool make_address(const std::string& path, sockaddr_un& addr) {
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "ERROR: handoff socket path too long: '" << path << "'\n";
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return true;
+}
+
+static void set_timeout(int fd, int seconds) {
+    struct timeval tv{seconds, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+int systemd_listen_fds(int& ipv4_fd, int& ipv6_fd) {
+    const char* pid = getenv("LISTEN_PID");
+    const char* fds = getenv("LISTEN_FDS");
+    if (!pid || !fds || std::atoi(pid) != getpid())
+        return 0;
+
+    int count = std::atoi(fds);
+    int adopted = 0;
+    // Passed sockets start at fd 3 (SD_LISTEN_FDS_START)
+    for (int fd = 3; fd < 3 + count; ++fd) {
+        // Passed without FD_CLOEXEC, like sd_listen_fds() keep them out of re-exec'd children
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        int type = 0;
+        socklen_t len = sizeof(type);
+        sockaddr_storage addr{};
+        socklen_t addr_len = sizeof(addr);
+        if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) < 0 || type != SOCK_DGRAM ||
+            getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) < 0) {
+            std::cerr << "WARNING: ignoring passed fd " << fd << ", not a UDP socket\n";
+            continue;
+        }
+
+        if (addr.ss_family == AF_INET && ipv4_fd < 0) { ipv4_fd = fd; adopted++; }
+        else if (addr.ss_family == AF_INET6 && ipv6_fd < 0) { ipv6_fd = fd; adopted++; }
+    }
+
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_FDNAMES");
+    return adopted;
+}
+
+int handoff_receive(const std::string& path, int& ipv4_fd, int& ipv6_fd) {
+    sockaddr_un addr;
+    if (!make_address(path, addr)) return -1;
+
+    int conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn < 0) return -1;
+    if (connect(conn, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(conn); // No running proxy, bind normally
+        return -1;
+    }
+    set_timeout(conn, HANDOFF_READY_TIMEOUT);
+
+    uint8_t flags = 0;
+    iovec iov{&flags, sizeof(flags)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(conn, &msg, MSG_CMSG_CLOEXEC) <= 0) {
+        perror("ERROR: recvmsg (handoff)");
+        close(conn);
+        return -1;
+    }
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        std::cerr << "ERROR: handoff message without sockets\n";
+        close(conn);
+        return -1;
+    }
+
+    int fds[2] = {-1, -1};
+    memcpy(fds, CMSG_DATA(cmsg), cmsg->cmsg_len - CMSG_LEN(0));
+    int next = 0;
+    if (flags & HANDOFF_HAS_IPV4) ipv4_fd = fds[next++];
+    if (flags & HANDOFF_HAS_IPV6) ipv6_fd = fds[next++];
+
+    return conn;
+}
+
+void handoff_ready(int conn) {
+    char ready = HANDOFF_READY;
+    if (send(conn, &ready, 1, MSG_NOSIGNAL) != 1) {
+        perror("ERROR: send (handoff)");
+    }
+    close(conn);
+}
+
+// Only same user or root may take listening sockets over
+static bool peer_allowed(int conn) {
+    ucred cred{};
+    socklen_t len = sizeof(cred);
+    if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) < 0) {
+        perror("ERROR: getsockopt SO_PEERCRED (handoff)");
+        return false;
+    }
+    if (cred.uid == geteuid() || cred.uid == 0) return true;
+
+    std::cerr << "WARNING: handoff refused to pid " << cred.pid << " of uid " << cred.uid << "\n";
+    return false;
+}
+
+// Pass both sockets and wait until new process confirms its workers run
+static bool serve_connection(int conn, int ipv4_fd, int ipv6_fd) {
+    if (!peer_allowed(conn)) return false;
+
+    uint8_t flags = 0;
+    int fds[2];
+    int count = 0;
+    if (ipv4_fd >= 0) { flags |= HANDOFF_HAS_IPV4; fds[count++] = ipv4_fd; }
+    if (ipv6_fd >= 0) { flags |= HANDOFF_HAS_IPV6; fds[count++] = ipv6_fd; }
+
+    iovec iov{&flags, sizeof(flags)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(count * sizeof(int));
+    memcpy(CMSG_DATA(cmsg), fds, count * sizeof(int));
+
+    if (sendmsg(conn, &msg, MSG_NOSIGNAL) < 0) {
+        perror("ERROR: sendmsg (handoff)");
+        return false;
+    }
+
+    set_timeout(conn, HANDOFF_READY_TIMEOUT);
+    char ready = 0;
+    return recv(conn, &ready, 1, 0) == 1 && ready == HANDOFF_READY;
+}
+
+static void reexec(char** argv) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Same command line, so a binary replaced on disk is picked up
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    if (pid < 0) perror("ERROR: fork (re-exec)");
+}
+
+void handoff_server(volatile sig_atomic_t& running, const std::string& path, char** argv,
+                    int ipv4_fd, int ipv6_fd) {
+    sockaddr_un addr;
+    if (!make_address(path, addr)) return;
+
+    // Previous process already handed off or is gone, path is ours now
+    unlink(path.c_str());
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    // Owner only, set before listen() so nobody connects while the mode is still default
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        chmod(path.c_str(), 0600) < 0 || listen(listen_fd, 1) < 0) {
+        perror("ERROR: handoff socket");
+        if (listen_fd >= 0) close(listen_fd);
+        return;
+    }
+
+    while (running) {
+        if (reexec_requested) {
+            reexec_requested = 0;
+            reexec(argv);
+        }
+        while (waitpid(-1, nullptr, WNOHANG) > 0) {} // Reap failed re-exec children
+
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(listen_fd, &fds);
+        struct timeval tv{0, 250000};
+        if (select(listen_fd + 1, &fds, nullptr, nullptr, &tv) <= 0) continue;
+
+        int conn = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conn < 0) continue;
+
+        bool ready = serve_connection(conn, ipv4_fd, ipv6_fd);
+        close(conn);
+        if (ready) {
+            completed = true;
+            running = 0; // Workers finish in-flight queries and stop reading
+            break;
+        }
+        std::cerr << "WARNING: new process did not take over sockets, keep serving\n";
+    }
+
+    close(listen_fd);
+}
+
+bool handoff_completed() {
+    return completed;
+}
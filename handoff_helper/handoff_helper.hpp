@@ -0,0 +1,31 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <csignal>
+#include <string>
+
+constexpr int HANDOFF_READY_TIMEOUT = 5; // Seconds old process waits for new one to start workers
+
+// SIGHUP sets this, handoff server then re-executes the binary with same arguments
+extern volatile sig_atomic_t reexec_requested;
+
+// Adopt sockets passed by systemd (LISTEN_FDS), returns number of adopted sockets
+int systemd_listen_fds(int& ipv4_fd, int& ipv6_fd);
+
+// Take listening sockets over from running proxy, returns connection for handoff_ready() or -1
+int handoff_receive(const std::string& path, int& ipv4_fd, int& ipv6_fd);
+
+// Tell old process our workers run, it stops reading and exits after in-flight queries
+void handoff_ready(int conn);
+
+// Serve sockets to a newer process until handed off or `running` is cleared
+void handoff_server(volatile sig_atomic_t& running, const std::string& path, char** argv,
+                    int ipv4_fd, int ipv6_fd);
+
+// True once sockets were handed to a new process
+bool handoff_completed();
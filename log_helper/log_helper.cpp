@@ -0,0 +1,269 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <iostream>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+
+#include "log_helper.hpp"
+#include "worker_helper.hpp"
+
+// Header written at start of every log file or socket connection
+static const char QUERY_LOG_MAGIC[8] = {'D', 'N', 'S', 'Q', 'L', 'O', 'G', QUERY_LOG_VERSION};
+
+constexpr size_t QUERY_LOG_FIXED_LENGTH = 43; // Record without qname bytes
+
+// Single producer (worker) single consumer (writer) byte ring
+struct query_log_ring {
+    uint8_t data[QUERY_LOG_RING_SIZE];
+    std::atomic<size_t> head{0}; // Written by worker
+    std::atomic<size_t> tail{0}; // Written by writer
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+static query_log_ring rings[WORKER_SLOTS];
+static worker_registry ring_count{0};
+static thread_local query_log_ring* local_ring = nullptr;
+static std::atomic<bool> enabled{false};
+
+static std::string log_path;
+static bool log_is_socket = false;
+static int log_fd = -1;
+static size_t log_written = 0;
+static uint64_t log_lost = 0; // Records discarded by writer while target is unavailable
+
+static uint8_t pending[QUERY_LOG_PENDING_SIZE];
+static size_t pending_length = 0;
+
+static inline void put16(uint8_t* p, uint16_t v) { p[0] = v >> 8; p[1] = v & 0xFF; }
+static inline void put32(uint8_t* p, uint32_t v) { put16(p, v >> 16); put16(p + 2, v & 0xFFFF); }
+static inline void put64(uint8_t* p, uint64_t v) { put32(p, v >> 32); put32(p + 4, v & 0xFFFFFFFF); }
+
+static int connect_target() {
+    int fd;
+    if (log_is_socket) {
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, log_path.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            close(fd);
+            return -1;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    } else {
+        fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC, 0644);
+        if (fd < 0) return -1;
+    }
+
+    // Magic goes first so consumer can verify format version, restarted proxy appends without it
+    struct stat st{};
+    bool empty = log_is_socket || (fstat(fd, &st) == 0 && st.st_size == 0);
+    pending_length = 0;
+    if (empty) {
+        memcpy(pending, QUERY_LOG_MAGIC, sizeof(QUERY_LOG_MAGIC));
+        pending_length = sizeof(QUERY_LOG_MAGIC);
+    }
+    log_written = log_is_socket ? 0 : st.st_size;
+    return fd;
+}
+
+bool query_log_open(const std::string& target) {
+    if (target.rfind("unix:", 0) == 0) {
+        log_is_socket = true;
+        log_path = target.substr(5);
+        if (log_path.size() >= sizeof(sockaddr_un::sun_path)) {
+            std::cerr << "ERROR: query log socket path too long: '" << log_path << "'\n";
+            return false;
+        }
+    } else {
+        log_is_socket = false;
+        log_path = target;
+    }
+
+    log_fd = connect_target();
+    if (log_fd < 0 && !log_is_socket) {
+        perror("ERROR: open (query log)");
+        return false;
+    }
+    if (log_fd < 0) {
+        // Consumer may start later, writer keeps reconnecting
+        std::cerr << "WARNING: query log socket '" << log_path << "' not available yet\n";
+    }
+
+    enabled = true;
+    return true;
+}
+
+void query_log_attach() {
+    if (!enabled) return;
+
+    int index = worker_claim(ring_count, "query log");
+    if (index >= 0) local_ring = &rings[index];
+}
+
+void query_log_write(const dns_packet& pkt, const dns_query& query, QUERY_VERDICT verdict) {
+    query_log_ring* ring = local_ring;
+    if (!ring) return;
+
+    size_t qname_length = std::min<size_t>(query.qname.size(), 255);
+    size_t length = QUERY_LOG_FIXED_LENGTH + qname_length;
+
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    size_t tail = ring->tail.load(std::memory_order_acquire);
+    if (QUERY_LOG_RING_SIZE - (head - tail) < length) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint8_t record[QUERY_LOG_FIXED_LENGTH + 255] = {};
+    uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    put16(record, length - 2);
+    record[2] = QUERY_LOG_VERSION;
+    record[3] = verdict;
+    put64(record + 4, now);
+    put32(record + 12, query.upstream_rtt_us);
+    put16(record + 16, query.qtype);
+    put16(record + 18, query.qclass);
+    put16(record + 20, query.id);
+    record[22] = query.rcode;
+
+    if (pkt.clientAddr.ss_family == AF_INET) {
+        const sockaddr_in* addr4 = reinterpret_cast<const sockaddr_in*>(&pkt.clientAddr);
+        record[23] = 4;
+        memcpy(record + 24, &addr4->sin_port, 2);
+        memcpy(record + 26, &addr4->sin_addr, 4);
+    } else if (pkt.clientAddr.ss_family == AF_INET6) {
+        const sockaddr_in6* addr6 = reinterpret_cast<const sockaddr_in6*>(&pkt.clientAddr);
+        record[23] = 6;
+        memcpy(record + 24, &addr6->sin6_port, 2);
+        memcpy(record + 26, &addr6->sin6_addr, 16);
+    }
+
+    record[42] = qname_length;
+    memcpy(record + QUERY_LOG_FIXED_LENGTH, query.qname.data(), qname_length);
+
+    for (size_t i = 0; i < length; ++i) {
+        ring->data[(head + i) % QUERY_LOG_RING_SIZE] = record[i];
+    }
+    ring->head.store(head + length, std::memory_order_release);
+    ring->records.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Move whole records from worker rings to pending batch, returns true if anything moved
+static bool drain_rings() {
+    bool moved = false;
+    int count = worker_claimed(ring_count);
+
+    for (int r = 0; r < count; ++r) {
+        query_log_ring& ring = rings[r];
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+        size_t head = ring.head.load(std::memory_order_acquire);
+
+        while (tail < head) {
+            size_t length = 2 + ((ring.data[tail % QUERY_LOG_RING_SIZE] << 8) |
+                                 ring.data[(tail + 1) % QUERY_LOG_RING_SIZE]);
+            if (log_fd >= 0 && pending_length + length > QUERY_LOG_PENDING_SIZE)
+                break; // Batch full, leave rest in ring
+
+            if (log_fd >= 0) {
+                for (size_t i = 0; i < length; ++i) {
+                    pending[pending_length++] = ring.data[(tail + i) % QUERY_LOG_RING_SIZE];
+                }
+            } else {
+                log_lost++;
+            }
+            tail += length;
+            moved = true;
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+    return moved;
+}
+
+// Flush pending batch without blocking, keeps unwritten rest for next round
+static void flush_pending() {
+    if (log_fd < 0 || pending_length == 0) return;
+
+    ssize_t sent = log_is_socket
+        ? send(log_fd, pending, pending_length, MSG_NOSIGNAL | MSG_DONTWAIT)
+        : write(log_fd, pending, pending_length);
+
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+        // Consumer gone, drop batch and reconnect later
+        close(log_fd);
+        log_fd = -1;
+        pending_length = 0;
+        return;
+    }
+
+    memmove(pending, pending + sent, pending_length - sent);
+    pending_length -= sent;
+    log_written += sent;
+
+    if (!log_is_socket && log_written >= QUERY_LOG_ROTATE_SIZE && pending_length == 0) {
+        close(log_fd);
+        std::string rotated = log_path + ".1";
+        rename(log_path.c_str(), rotated.c_str());
+        log_fd = connect_target();
+    }
+}
+
+void query_log_writer(volatile sig_atomic_t& running) {
+    auto last_connect = std::chrono::steady_clock::now();
+
+    while (running) {
+        if (log_fd < 0 && std::chrono::steady_clock::now() - last_connect > std::chrono::seconds(1)) {
+            log_fd = connect_target();
+            last_connect = std::chrono::steady_clock::now();
+        }
+
+        bool moved = drain_rings();
+        flush_pending();
+
+        if (!moved) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+}
+
+void query_log_close(bool verbose) {
+    if (!enabled) return;
+
+    // Final flush after workers and writer stopped
+    drain_rings();
+    flush_pending();
+
+    if (log_fd >= 0) close(log_fd);
+    log_fd = -1;
+
+    if (verbose) {
+        uint64_t records = 0, dropped = 0;
+        int count = worker_claimed(ring_count);
+        for (int r = 0; r < count; ++r) {
+            records += rings[r].records.load();
+            dropped += rings[r].dropped.load();
+        }
+        std::cout << "Query log: " << records << " records, " << dropped + log_lost << " dropped\n";
+    }
+}
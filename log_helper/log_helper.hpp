@@ -0,0 +1,43 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <csignal>
+
+#include "dns_structures.hpp"
+
+constexpr size_t QUERY_LOG_RING_SIZE = 64 * 1024;            // Per-worker record buffer
+constexpr size_t QUERY_LOG_PENDING_SIZE = 256 * 1024;        // Writer batch buffer
+constexpr size_t QUERY_LOG_ROTATE_SIZE = 64 * 1024 * 1024;   // Rotate log file after this many bytes
+constexpr uint8_t QUERY_LOG_VERSION = 1;
+
+// Verdict stored in every query log record
+enum QUERY_VERDICT {
+    VERDICT_ALLOWED         = 0, // Relayed to upstream
+    VERDICT_BLOCKED         = 1, // Matched filter list
+    VERDICT_NOT_IMPLEMENTED = 2, // Unsupported QTYPE/QCLASS/QDCOUNT
+    VERDICT_MALFORMED       = 3, // FORMERR
+    VERDICT_LOCAL           = 4, // Answered from local zone
+    VERDICT_SHED            = 5, // SERVFAIL without relaying, admission limit or upstream send failed
+};
+
+// Open log target, "unix:<path>" streams to UNIX socket, anything else is rotating file
+bool query_log_open(const std::string& target);
+
+// Called by each worker thread before logging, binds it to its own ring buffer
+void query_log_attach();
+
+// Append record for answered query, never blocks, drops record when buffer is full
+void query_log_write(const dns_packet& pkt, const dns_query& query, QUERY_VERDICT verdict);
+
+// Writer thread body, batches records from all workers until `running` is cleared
+void query_log_writer(volatile sig_atomic_t& running);
+
+void query_log_close(bool verbose);
@@ -10,12 +10,14 @@
 #include <string>
 #include <cstring>
 #include <cstdint>
+#include <cstdlib>
 #include <cctype>
 #include <csignal>
 #include <atomic>
 #include <algorithm>
 #include <fstream>
 #include <thread>
+#include <chrono>
 
 #include <unistd.h>
 #include <arpa/inet.h>
@@ -31,10 +33,20 @@
 #include "print_helper.hpp"
 #include "filter_helper.hpp"
 #include "dns_structures.hpp"
+#include "sinkhole_helper.hpp"
+#include "socket_helper.hpp"
+#include "zone_helper.hpp"
+#include "log_helper.hpp"
+#include "xdp_helper.hpp"
+#include "topk_helper.hpp"
+#include "trace_helper.hpp"
+#include "handoff_helper.hpp"
 
 volatile sig_atomic_t running = 1;
 proxy_config config;
 upstream_server upstream;
+sinkhole_templates sinkhole;
+local_zone local_records;
 
 #include <fcntl.h>
 
@@ -60,6 +72,22 @@ void init_signal_handling() {
     }
 }
 
+void reexec_signal_handler([[maybe_unused]] int signal) { reexec_requested = 1; }
+
+// SIGHUP starts new process taking over sockets, only with handoff socket configured
+void init_reexec_signal() {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = reexec_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0;
+
+    if (sigaction(SIGHUP, &sa, NULL) == -1) {
+        perror("sigaction");
+        exit(1);
+    }
+}
+
 void resolve_upstream(const std::string& host, upstream_server& up) {
     addrinfo hints{}, *res = nullptr;
     hints.ai_socktype = SOCK_DGRAM;
@@ -115,6 +143,36 @@ uint16_t parse_port(const char* optarg) {
     return static_cast<uint16_t>(value);
 }
 
+// Whole argument must be a decimal number in range, otherwise warn and use fallback
+uint32_t parse_unsigned(const char* optarg, uint32_t min, uint32_t max, const char* name,
+                        uint32_t fallback, const char* fallback_name = nullptr) {
+    size_t len = std::strlen(optarg);
+    bool digits = len > 0 && len <= 10;
+    for (size_t pos = 0; digits && pos < len; ++pos) {
+        if (!std::isdigit(static_cast<unsigned char>(optarg[pos]))) digits = false;
+    }
+
+    unsigned long long value = digits ? std::strtoull(optarg, nullptr, 10) : 0;
+    if (!digits || value < min || value > max) {
+        std::cerr << "WARNING: " << name << " '" << optarg << "' is not a number in range (" << min << "-" << max << "). Using ";
+        if (fallback_name) std::cerr << fallback_name;
+        else std::cerr << "default " << fallback;
+        std::cerr << ".\n";
+        return fallback;
+    }
+
+    return static_cast<uint32_t>(value);
+}
+
+BLOCK_MODE parse_block_mode(const char* optarg) {
+    if (std::strcmp(optarg, "refused") == 0) return BLOCK_MODE_REFUSED;
+    if (std::strcmp(optarg, "nxdomain") == 0) return BLOCK_MODE_NXDOMAIN;
+    if (std::strcmp(optarg, "null") == 0) return BLOCK_MODE_NULL;
+
+    std::cerr << "WARNING: Block mode '" << optarg << "' is not one of refused/nxdomain/null. Using default refused.\n";
+    return BLOCK_MODE_REFUSED;
+}
+
 void parse_arguments(int argc, char *argv[], proxy_config &config) {
     if (argc < 3) {
         print_usage(argv[0]);
@@ -145,6 +203,93 @@ void parse_arguments(int argc, char *argv[], proxy_config &config) {
             }
             config.filter_file = argv[++i];
         }
+        else if (std::strcmp(argv[i], "-b") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -b\n";
+                exit(EXIT_FAILURE);
+            }
+            config.block_mode = parse_block_mode(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "-t") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -t\n";
+                exit(EXIT_FAILURE);
+            }
+            config.block_ttl = parse_unsigned(argv[++i], 0, 2147483647, "TTL", 300); // RFC 2181: TTL is 31-bit
+        }
+        else if (std::strcmp(argv[i], "-l") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -l\n";
+                exit(EXIT_FAILURE);
+            }
+            config.query_log = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-x") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -x\n";
+                exit(EXIT_FAILURE);
+            }
+            config.xdp_pin_dir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-k") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -k\n";
+                exit(EXIT_FAILURE);
+            }
+            config.topk_report = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-u") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -u\n";
+                exit(EXIT_FAILURE);
+            }
+            config.handoff_socket = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-q") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -q\n";
+                exit(EXIT_FAILURE);
+            }
+            config.max_outstanding = parse_unsigned(argv[++i], 1, 4096, "Outstanding limit", 256);
+        }
+        else if (std::strcmp(argv[i], "-z") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -z\n";
+                exit(EXIT_FAILURE);
+            }
+            config.local_zone = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-r") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -r\n";
+                exit(EXIT_FAILURE);
+            }
+            config.trace_file = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "-n") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -n\n";
+                exit(EXIT_FAILURE);
+            }
+            config.trace_sample = parse_unsigned(argv[++i], 1, 1000000, "Trace sampling", 100);
+        }
+        else if (std::strcmp(argv[i], "-i") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -i\n";
+                exit(EXIT_FAILURE);
+            }
+            config.rcvbuf = parse_unsigned(argv[++i], 4096, 268435456, "Buffer size", 0, "kernel default");
+        }
+        else if (std::strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                std::cerr << "ERROR: missing argument for -o\n";
+                exit(EXIT_FAILURE);
+            }
+            config.sndbuf = parse_unsigned(argv[++i], 4096, 268435456, "Buffer size", 0, "kernel default");
+        }
+        else if (std::strcmp(argv[i], "-g") == 0) {
+            config.grow_rcvbuf = true;
+        }
         else if (std::strcmp(argv[i], "-v") == 0) {
             config.verbose = true;
         }
@@ -169,7 +314,7 @@ void parse_arguments(int argc, char *argv[], proxy_config &config) {
 }
 
 int bind_ipv4(uint16_t port) {
-    int sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int sock_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_port = htons(port);
@@ -184,7 +329,7 @@ int bind_ipv4(uint16_t port) {
 }
 
 int bind_ipv6(uint16_t port) {
-    int sock_fd = socket(AF_INET6, SOCK_DGRAM, 0);
+    int sock_fd = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
     int on = 1;
     setsockopt(sock_fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
     sockaddr_in6 addr{};
@@ -200,69 +345,10 @@ int bind_ipv6(uint16_t port) {
     return sock_fd;
 }
 
-bool relay(uint8_t* data, ssize_t len, const dns_packet& pkt, int timeout_sec = 3) {
-    // Prefer IPv4 if available
-    int family = upstream.has_ipv4 ? AF_INET : AF_INET6;
-    sockaddr* up_addr = upstream.has_ipv4
-        ? (sockaddr*)&upstream.ipv4
-        : (sockaddr*)&upstream.ipv6;
-    socklen_t up_len = upstream.has_ipv4
-        ? sizeof(sockaddr_in)
-        : sizeof(sockaddr_in6);
-
-    int sock = socket(family, SOCK_DGRAM, 0);
-    if (sock < 0) {
-        perror("ERROR: socket (upstream)");
-        return false;
-    }
-
-    // Send to upstream
-    if (sendto(sock, data, len, 0, up_addr, up_len) < 0) {
-        perror("ERROR: sendto (upstream)");
-        close(sock);
-        return false;
-    }
-
-    // Set receive timeout for upstream reply
-    uint8_t buffer[BUFFER_SIZE];
-    struct timeval tv{timeout_sec, 0};
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-    // Receive from upstream
-    ssize_t recvd = recv(sock, buffer, sizeof(buffer), 0);
-    if (recvd < 0) {
-        perror("ERROR: recv (upstream)");
-        close(sock);
-        return false;
-    }
-
-    if (config.verbose) {
-        std::string resolved_ip = extract_ip(buffer, recvd);
-        if (!resolved_ip.empty()) {
-            std::cout << "  Resolved: " << resolved_ip << "\n";
-        } else {
-            std::cout << "  No A/AAAA record in response\n";
-        }
-    }
-
-    // Send response back to client
-    if (sendto(pkt.sockfd, buffer, recvd, 0, (sockaddr*)&pkt.clientAddr, pkt.clientLen) < 0) {
-        perror("ERROR: sendto (client)");
-        close(sock);
-        return false;
-    }
-
-    if(config.verbose) {
-        std::cout << "  Response: " << RCODE_to_string(RCODE_NO_ERROR) << "\n";
-    }
-
-    close(sock);
-    return true;
-}
-
-dns_query analyze_query(const dns_packet &pkt, const std::unordered_set<std::string> &filters, const proxy_config &cfg)
+dns_query analyze_query(const dns_packet &pkt, const filter_set &filters, const proxy_config &cfg, uint64_t trace_start)
 {
     dns_query query;
+    query.trace_start = trace_start;
     if (pkt.length < DNS_HEADER_LENGTH)
         return query;
 
@@ -299,13 +385,16 @@ dns_query analyze_query(const dns_packet &pkt, const std::unordered_set<std::str
 
     query.qtype  = (pkt.data[offset] << 8) | pkt.data[offset + 1];
     query.qclass = (pkt.data[offset + 2] << 8) | pkt.data[offset + 3];
+    query.question_end = offset + 4;
 
     // --- Normalize for checking ---
     std::string domain = query.qname;
     std::transform(domain.begin(), domain.end(), domain.begin(), ::tolower);
 
     // --- Check filter list ---
-    query.blocked = is_blocked(domain, filters);
+    uint64_t filter_start = trace_mark(query.trace_start);
+    query.blocked = is_blocked_cached(domain, filters);
+    trace_span(query.trace_start, "is_blocked", filter_start);
 
     query.valid = true;
 
@@ -346,21 +435,275 @@ void send_response(int sock_fd, const dns_packet &pkt, RCODE code) {
     }
 }
 
+RCODE send_block_response(int sock_fd, const dns_packet &pkt, const dns_query &query) {
+    if (config.block_mode == BLOCK_MODE_REFUSED) {
+        send_response(sock_fd, pkt, RCODE_REFUSED);
+        return RCODE_REFUSED;
+    }
+
+    uint8_t response[BUFFER_SIZE];
+    ssize_t len = build_sinkhole_response(sinkhole, config.block_mode, pkt, query, response);
+    if (len < 0) {
+        send_response(sock_fd, pkt, RCODE_REFUSED);
+        return RCODE_REFUSED;
+    }
+
+    if(config.verbose) {
+        std::cout << "  Response: " << RCODE_to_string(static_cast<RCODE>(response[3] & 0x0F)) << " (sinkhole)\n";
+    }
+
+    if(sendto(sock_fd, response, len, 0, reinterpret_cast<const sockaddr*>(&pkt.clientAddr), pkt.clientLen) < 0) {
+        perror("ERROR: sendto (client)");
+    }
+    return static_cast<RCODE>(response[3] & 0x0F);
+}
+
+bool send_local_response(int sock_fd, const dns_packet &pkt, const dns_query &query) {
+    uint8_t response[BUFFER_SIZE];
+    ssize_t len = build_local_response(local_records, pkt, query, response);
+    if (len < 0) return false;
+
+    if(config.verbose) {
+        std::cout << "  Response: " << RCODE_to_string(RCODE_NO_ERROR) << " (local, " << (response[7] | response[6] << 8) << " records)\n";
+    }
+
+    if(sendto(sock_fd, response, len, 0, reinterpret_cast<const sockaddr*>(&pkt.clientAddr), pkt.clientLen) < 0) {
+        perror("ERROR: sendto (client)");
+    }
+    return true;
+}
+
+// Admission counters summed from all workers on exit
+std::atomic<uint64_t> relayed_total{0};
+std::atomic<uint64_t> shed_total{0};
+std::atomic<uint64_t> timeouts_total{0};
+std::atomic<uint64_t> send_failures_total{0};
+std::atomic<size_t> peak_outstanding{0};
+
+bool relay_open(relay_state& relay) {
+    // Prefer IPv4 if available
+    int family = upstream.has_ipv4 ? AF_INET : AF_INET6;
+    sockaddr* up_addr = upstream.has_ipv4
+        ? (sockaddr*)&upstream.ipv4
+        : (sockaddr*)&upstream.ipv6;
+    socklen_t up_len = upstream.has_ipv4
+        ? sizeof(sockaddr_in)
+        : sizeof(sockaddr_in6);
+
+    relay.sock = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (relay.sock < 0) {
+        perror("ERROR: socket (upstream)");
+        return false;
+    }
+
+    // Connected socket only accepts answers from upstream address
+    if (connect(relay.sock, up_addr, up_len) < 0) {
+        perror("ERROR: connect (upstream)");
+        close(relay.sock);
+        relay.sock = -1;
+        return false;
+    }
+
+    relay.limit = config.max_outstanding;
+    relay.slots.resize(relay.limit);
+    relay.id_to_slot.assign(65536, -1);
+    for (size_t i = relay.limit; i-- > 0;) relay.free_slots.push_back(i);
+    return true;
+}
+
+void relay_close(relay_state& relay) {
+    if (relay.sock >= 0) close(relay.sock);
+    relay.sock = -1;
+
+    relayed_total += relay.relayed;
+    shed_total += relay.shed;
+    timeouts_total += relay.timeouts;
+    send_failures_total += relay.send_failures;
+    size_t peak = peak_outstanding.load();
+    while (relay.peak > peak && !peak_outstanding.compare_exchange_weak(peak, relay.peak)) {}
+}
+
+void relay_release(relay_state& relay, uint16_t index) {
+    relay_slot& slot = relay.slots[index];
+    relay.id_to_slot[slot.upstream_id] = -1;
+    slot.in_use = false;
+    relay.free_slots.push_back(index);
+    relay.outstanding--;
+
+    if (relay.overloaded && relay.outstanding <= relay.limit / 2) {
+        relay.overloaded = false;
+        std::cerr << "WARNING: upstream recovered, " << relay.outstanding << " queries outstanding\n";
+    }
+}
+
+// Send query upstream under random ID, false when over admission limit or send failed
+bool relay_submit(relay_state& relay, const dns_packet& pkt, const dns_query& query) {
+    if (relay.outstanding >= relay.limit) {
+        relay.shed++;
+        if (!relay.overloaded) {
+            relay.overloaded = true;
+            std::cerr << "WARNING: upstream overloaded, shedding new queries (" << relay.limit << " outstanding)\n";
+        }
+        return false;
+    }
+
+    uint16_t upstream_id;
+    do {
+        upstream_id = relay.rng() & 0xFFFF;
+    } while (relay.id_to_slot[upstream_id] != -1);
+
+    uint16_t index = relay.free_slots.back();
+    relay_slot& slot = relay.slots[index];
+    slot.pkt = pkt;
+    slot.query = query;
+    slot.pkt.data[0] = upstream_id >> 8;
+    slot.pkt.data[1] = upstream_id & 0xFF;
+
+    if (send(relay.sock, slot.pkt.data, slot.pkt.length, 0) < 0) {
+        relay.send_failures++;
+        if (!relay.send_failing) {
+            relay.send_failing = true;
+            std::cerr << "WARNING: send to upstream failed (" << std::strerror(errno) << "), answering SERVFAIL\n";
+        }
+        return false;
+    }
+    relay.send_failing = false;
+
+    relay.free_slots.pop_back();
+    relay.id_to_slot[upstream_id] = index;
+    slot.upstream_id = upstream_id;
+    slot.in_use = true;
+    slot.sent_at = std::chrono::steady_clock::now();
+    relay.deadlines.emplace_back(index, upstream_id);
+
+    relay.outstanding++;
+    relay.relayed++;
+    relay.peak = std::max(relay.peak, relay.outstanding);
+    return true;
+}
+
+// Forward all upstream answers waiting on socket to their clients
+void relay_receive(relay_state& relay) {
+    uint8_t buffer[BUFFER_SIZE];
+
+    while (true) {
+        ssize_t recvd = recv(relay.sock, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (recvd < 0) {
+            if (errno == ECONNREFUSED) continue; // ICMP from upstream, query expires later
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("ERROR: recv (upstream)");
+            return;
+        }
+        if (recvd < DNS_HEADER_LENGTH) continue;
+
+        uint16_t upstream_id = (buffer[0] << 8) | buffer[1];
+        int16_t index = relay.id_to_slot[upstream_id];
+        if (index < 0) continue; // Late answer of expired query
+
+        relay_slot& slot = relay.slots[index];
+        dns_query& query = slot.query;
+        trace_async(query.trace_start, "upstream", std::chrono::duration_cast<std::chrono::nanoseconds>(
+            slot.sent_at.time_since_epoch()).count());
+        query.upstream_rtt_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - slot.sent_at).count();
+        query.rcode = buffer[3] & 0x0F;
+
+        buffer[0] = query.id >> 8;
+        buffer[1] = query.id & 0xFF;
+
+        if (config.verbose) {
+            std::string resolved_ip = extract_ip(buffer, recvd);
+            std::cout << "Upstream answer:\n";
+            std::cout << "  ID: " << query.id << "\n";
+            if (!resolved_ip.empty()) {
+                std::cout << "  Resolved: " << resolved_ip << "\n";
+            } else {
+                std::cout << "  No A/AAAA record in response\n";
+            }
+        }
+
+        // Send response back to client
+        uint64_t send_start = trace_mark(query.trace_start);
+        if (sendto(slot.pkt.sockfd, buffer, recvd, 0, (sockaddr*)&slot.pkt.clientAddr, slot.pkt.clientLen) < 0) {
+            perror("ERROR: sendto (client)");
+        } else if (config.verbose) {
+            std::cout << "  Response: " << RCODE_to_string(static_cast<RCODE>(query.rcode)) << "\n";
+        }
+
+        trace_span(query.trace_start, "sendto", send_start);
+
+        query_log_write(slot.pkt, query, VERDICT_ALLOWED);
+        trace_query(query, VERDICT_ALLOWED, config.server.c_str());
+        relay_release(relay, index);
+    }
+}
+
+// Answer SERVFAIL to queries upstream did not answer in time, returns time to next deadline
+std::chrono::microseconds relay_expire(relay_state& relay) {
+    auto now = std::chrono::steady_clock::now();
+    auto timeout = std::chrono::seconds(UPSTREAM_TIMEOUT_SEC);
+
+    while (!relay.deadlines.empty()) {
+        auto [index, upstream_id] = relay.deadlines.front();
+        relay_slot& slot = relay.slots[index];
+        if (!slot.in_use || slot.upstream_id != upstream_id) {
+            relay.deadlines.pop_front(); // Already answered
+            continue;
+        }
+        if (now - slot.sent_at < timeout) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(slot.sent_at + timeout - now);
+        }
+
+        slot.pkt.data[0] = slot.query.id >> 8;
+        slot.pkt.data[1] = slot.query.id & 0xFF;
+        send_response(slot.pkt.sockfd, slot.pkt, RCODE_SERVER_FAILURE);
+        slot.query.rcode = RCODE_SERVER_FAILURE;
+        query_log_write(slot.pkt, slot.query, VERDICT_ALLOWED);
+        trace_async(slot.query.trace_start, "upstream timeout", std::chrono::duration_cast<std::chrono::nanoseconds>(
+            slot.sent_at.time_since_epoch()).count());
+        trace_query(slot.query, VERDICT_ALLOWED, config.server.c_str());
+
+        relay.timeouts++;
+        relay.deadlines.pop_front();
+        relay_release(relay, index);
+    }
+    return timeout;
+}
+
+void print_admission_stats() {
+    std::cout << "Upstream: " << relayed_total << " relayed, " << shed_total << " shed, "
+              << timeouts_total << " timed out, " << send_failures_total << " send failures, peak " << peak_outstanding << "/" << config.max_outstanding
+              << " outstanding per worker\n";
+}
+
 // Worker per-socket
-void worker(int sock, const std::unordered_set<std::string>& filters) {
+void worker(int sock, const filter_set& filters) {
     dns_packet pkt{};
     pkt.sockfd = sock;
-    
-    while (running) {
+    query_log_attach();
+    if (!config.topk_report.empty()) topk_attach();
+    if (!config.trace_file.empty()) trace_attach(config.trace_sample);
+
+    relay_state relay;
+    if (!relay_open(relay)) return;
+
+    socket_stats socket_drops;
+    socket_stats_open(sock, socket_drops);
+
+    // After stop, keep serving upstream answers until in-flight queries finish
+    while (running || relay.outstanding > 0) {
+        auto next_deadline = relay_expire(relay);
+        topk_poll();
+
         fd_set fds;
         FD_ZERO(&fds);
-        FD_SET(sock, &fds);
+        if (running) FD_SET(sock, &fds);
+        FD_SET(relay.sock, &fds);
 
         struct timeval tv;
         tv.tv_sec = 0;
-        tv.tv_usec = 250000; // 250ms timeout
+        tv.tv_usec = std::min<long>(next_deadline.count() + 1, 250000); // 250ms timeout
 
-        int ret = select(sock + 1, &fds, nullptr, nullptr, &tv);
+        int ret = select(std::max(sock, relay.sock) + 1, &fds, nullptr, nullptr, &tv);
 
         if (ret < 0) {
             if (errno == EINTR) continue; // Interrupted by signal
@@ -369,32 +712,69 @@ void worker(int sock, const std::unordered_set<std::string>& filters) {
         } else if (ret == 0) {
             continue; // timeout, loop around and check `running`
         }
-        
-        pkt.clientLen = sizeof(pkt.clientAddr);
-        pkt.length = recvfrom(sock, pkt.data, BUFFER_SIZE, 0, (sockaddr*)&pkt.clientAddr, &pkt.clientLen);
+
+        if (FD_ISSET(relay.sock, &fds)) relay_receive(relay);
+        if (!FD_ISSET(sock, &fds)) continue;
+
+        uint64_t trace_start = trace_sample();
+        // Non-blocking, socket may be shared with another process during handoff
+        pkt.length = socket_receive(sock, pkt, socket_drops, config.grow_rcvbuf);
 
         if (pkt.length < 0) {
-            if (errno == EINTR) continue;
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
             perror("ERROR: recvfrom");
             continue;
         }
 
-        dns_query query = analyze_query(pkt, filters, config);
+        trace_wakeup(trace_start, pkt.received_ns);
+        trace_span(trace_start, "recvfrom", trace_start);
+
+        uint64_t step_start = trace_mark(trace_start);
+        dns_query query = analyze_query(pkt, filters, config, trace_start);
+        trace_span(trace_start, "analyze_query", step_start);
+
+        step_start = trace_mark(trace_start);
+        QUERY_VERDICT verdict = VERDICT_ALLOWED;
+        bool relayed = false;
 
         if (!query.valid) {
             send_response(sock, pkt, RCODE_FORMAT_ERROR);
+            query.rcode = RCODE_FORMAT_ERROR;
+            verdict = VERDICT_MALFORMED;
         } else if (query.blocked) {
-            send_response(sock, pkt, RCODE_REFUSED);
+            query.rcode = send_block_response(sock, pkt, query);
+            verdict = VERDICT_BLOCKED;
+        } else if (send_local_response(sock, pkt, query)) {
+            query.rcode = RCODE_NO_ERROR;
+            verdict = VERDICT_LOCAL;
         } else if (query.qtype != QTYPE_A || query.qclass != QCLASS_IN || query.qdcount != 1) {
             send_response(sock, pkt, RCODE_NOT_IMPLEMENTED);
-        } else if (!relay(pkt.data, pkt.length, pkt)) {
+            query.rcode = RCODE_NOT_IMPLEMENTED;
+            verdict = VERDICT_NOT_IMPLEMENTED;
+        } else if (relay_submit(relay, pkt, query)) {
+            relayed = true; // Logged when upstream answers or query expires
+        } else {
+            // Over admission limit or upstream unreachable, fail fast
             send_response(sock, pkt, RCODE_SERVER_FAILURE);
+            query.rcode = RCODE_SERVER_FAILURE;
+            verdict = VERDICT_SHED;
+        }
+
+        trace_span(trace_start, relayed ? "relay_submit" : "respond", step_start);
+
+        if (!relayed) {
+            query_log_write(pkt, query, verdict);
+            trace_query(query, verdict, nullptr);
         }
+        topk_record(pkt, query);
 
         if(config.verbose) {
             std::cout << "--------------------------------------" << std::endl;
         }
     }
+
+    relay_close(relay);
+    socket_stats_close(socket_drops);
 }
 
 int main(int argc, char *argv[]) {
@@ -402,10 +782,38 @@ int main(int argc, char *argv[]) {
     parse_arguments(argc, argv, config);
 
     if (config.verbose) { print_config(config, upstream); }
-    std::unordered_set<std::string> filters = load_filters(config.filter_file, config.verbose);
+    filter_set filters = load_filters(config.filter_file, config.verbose);
+    init_sinkhole_templates(sinkhole, config.block_ttl);
+    if (!config.local_zone.empty()) local_records = load_local_zone(config.local_zone, config.verbose);
 
-    int ipv4_sock_fd = bind_ipv4(config.port);
-    int ipv6_sock_fd = bind_ipv6(config.port);
+    if (!config.query_log.empty() && !query_log_open(config.query_log)) {
+        return 1;
+    }
+
+    bool xdp_enabled = false;
+    if (!config.xdp_pin_dir.empty()) {
+        if (config.block_mode != BLOCK_MODE_REFUSED) {
+            std::cerr << "WARNING: XDP fast path answers only REFUSED, disabled for block mode "
+                      << BLOCK_MODE_to_string(config.block_mode) << "\n";
+        } else if (!(xdp_enabled = xdp_load_filters(config.xdp_pin_dir, filters, config.port, config.verbose))) {
+            std::cerr << "WARNING: XDP fast path not available, all queries handled in userspace\n";
+        }
+    }
+
+    // Sockets come from systemd, from running proxy over handoff socket, or are bound here
+    int ipv4_sock_fd = -1;
+    int ipv6_sock_fd = -1;
+    int handoff_conn = -1;
+
+    if (systemd_listen_fds(ipv4_sock_fd, ipv6_sock_fd) > 0) {
+        if (config.verbose) std::cout << "Using sockets passed by systemd\n";
+    } else if (!config.handoff_socket.empty() &&
+               (handoff_conn = handoff_receive(config.handoff_socket, ipv4_sock_fd, ipv6_sock_fd)) >= 0) {
+        if (config.verbose) std::cout << "Took over sockets from running proxy\n";
+    } else {
+        ipv4_sock_fd = bind_ipv4(config.port);
+        ipv6_sock_fd = bind_ipv6(config.port);
+    }
 
     if (ipv4_sock_fd < 0 && ipv6_sock_fd < 0) {
         std::cerr <<"ERROR: could not bind IPv4 and IPv6 sockets\n";
@@ -418,15 +826,49 @@ int main(int argc, char *argv[]) {
         std::cerr <<"ERROR: could not bind IPv6 socket\n";
     }
 
+    // Inherited sockets are tuned too, buffer sizes may differ from previous process
+    if (ipv4_sock_fd >= 0) tune_socket(ipv4_sock_fd, "IPv4", config.rcvbuf, config.sndbuf, !config.trace_file.empty(), config.verbose);
+    if (ipv6_sock_fd >= 0) tune_socket(ipv6_sock_fd, "IPv6", config.rcvbuf, config.sndbuf, !config.trace_file.empty(), config.verbose);
+
     std::vector<std::thread> threads;
     if (ipv4_sock_fd >= 0) threads.emplace_back(worker, ipv4_sock_fd, std::cref(filters));
     if (ipv6_sock_fd >= 0) threads.emplace_back(worker, ipv6_sock_fd, std::cref(filters));
 
+    // Workers run, old process may stop reading now
+    if (handoff_conn >= 0) handoff_ready(handoff_conn);
+
+    std::thread handoff_thread;
+    if (!config.handoff_socket.empty()) {
+        init_reexec_signal();
+        handoff_thread = std::thread(handoff_server, std::ref(running), std::cref(config.handoff_socket),
+                                     argv, ipv4_sock_fd, ipv6_sock_fd);
+    }
+
+    std::thread log_writer;
+    if (!config.query_log.empty()) log_writer = std::thread(query_log_writer, std::ref(running));
+    std::thread topk_writer;
+    if (!config.topk_report.empty()) topk_writer = std::thread(topk_dumper, std::ref(running), std::cref(config.topk_report));
+    std::thread trace_writer;
+    if (!config.trace_file.empty()) trace_writer = std::thread(trace_dumper, std::ref(running), std::cref(config.trace_file));
+
     for (auto& thread : threads) thread.join();
+    if (log_writer.joinable()) log_writer.join();
+    if (topk_writer.joinable()) topk_writer.join();
+    if (trace_writer.joinable()) trace_writer.join();
+    if (handoff_thread.joinable()) handoff_thread.join();
+    if (!config.topk_report.empty()) topk_dump(config.topk_report);
+    if (!config.trace_file.empty()) trace_dump(config.trace_file);
+    // New process owns the fast path after handoff
+    if (xdp_enabled && !handoff_completed()) xdp_disable(config.xdp_pin_dir);
+    query_log_close(config.verbose);
+    if (config.verbose) print_verdict_cache_stats();
+    if (config.verbose) print_admission_stats();
+    if (config.verbose) print_socket_drop_stats();
 
     if (ipv4_sock_fd >= 0) close(ipv4_sock_fd);
     if (ipv6_sock_fd >= 0) close(ipv6_sock_fd);
 
+    if (handoff_completed()) std::cout << std::endl << "Sockets handed over to new process";
     std::cout << std::endl << "DNS Proxy terminated successfully with exit code 0" << std::endl;
     return 0;
 }
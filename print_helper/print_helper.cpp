@@ -14,7 +14,16 @@
 #include "dns_structures.hpp"
 
 void print_usage(const char* prog) {
-    std::cerr << "Usage: " << prog << " -s server [-p port] -f filter_file [-v]\n";
+    std::cerr << "Usage: " << prog << " -s server [-p port] -f filter_file [-b refused|nxdomain|null] [-t ttl] [-l log_file|unix:socket] [-x bpf_pin_dir] [-k topk_report] [-u handoff_socket] [-q max_outstanding] [-z local_zone] [-r trace_file] [-n trace_sample] [-i rcvbuf] [-o sndbuf] [-g] [-v]\n";
+}
+
+const char* BLOCK_MODE_to_string(BLOCK_MODE mode) {
+    switch (mode) {
+        case BLOCK_MODE_REFUSED:  return "refused";
+        case BLOCK_MODE_NXDOMAIN: return "nxdomain";
+        case BLOCK_MODE_NULL:     return "null";
+        default:                  return "UNKNOWN";
+    }
 }
 
 void print_config(const proxy_config& config, const upstream_server& upstream) {
@@ -40,6 +49,27 @@ void print_config(const proxy_config& config, const upstream_server& upstream) {
 
     std::cout << std::left << std::setw(15) << "Port:" << config.port << "\n";
     std::cout << std::left << std::setw(15) << "Filter file:" << config.filter_file << "\n";
+    if (!config.local_zone.empty())
+        std::cout << std::left << std::setw(15) << "Local zone:" << config.local_zone << "\n";
+    std::cout << std::left << std::setw(15) << "Block mode:" << BLOCK_MODE_to_string(config.block_mode);
+    if (config.block_mode != BLOCK_MODE_REFUSED) std::cout << " (TTL " << config.block_ttl << ")";
+    std::cout << "\n";
+    std::cout << std::left << std::setw(15) << "Outstanding:" << config.max_outstanding << " per worker\n";
+    if (config.rcvbuf || config.sndbuf || config.grow_rcvbuf) {
+        std::cout << std::left << std::setw(15) << "Buffers:" << "receive " << (config.rcvbuf ? std::to_string(config.rcvbuf) : "default")
+                  << ", send " << (config.sndbuf ? std::to_string(config.sndbuf) : "default")
+                  << (config.grow_rcvbuf ? ", grow on drops" : "") << "\n";
+    }
+    if (!config.query_log.empty())
+        std::cout << std::left << std::setw(15) << "Query log:" << config.query_log << "\n";
+    if (!config.xdp_pin_dir.empty())
+        std::cout << std::left << std::setw(15) << "XDP maps:" << config.xdp_pin_dir << "\n";
+    if (!config.topk_report.empty())
+        std::cout << std::left << std::setw(15) << "Top-K report:" << config.topk_report << "\n";
+    if (!config.trace_file.empty())
+        std::cout << std::left << std::setw(15) << "Trace file:" << config.trace_file << " (1 of " << config.trace_sample << " queries)\n";
+    if (!config.handoff_socket.empty())
+        std::cout << std::left << std::setw(15) << "Handoff:" << config.handoff_socket << "\n";
     std::cout << std::left << std::setw(15) << "Verbose:" << (config.verbose ? "enabled" : "disabled") << "\n";
     std::cout << "==========================================\n";
 }
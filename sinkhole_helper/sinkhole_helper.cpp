@@ -0,0 +1,101 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <cstring>
+#include <arpa/inet.h>
+
+#include "qtype.hpp"
+#include "qclass.hpp"
+#include "rcode.hpp"
+#include "sinkhole_helper.hpp"
+
+void write_rr_header(uint8_t* rr, uint16_t type, uint32_t ttl, uint16_t rdlength) {
+    rr[0] = 0xC0;
+    rr[1] = DNS_HEADER_LENGTH;
+    rr[2] = type >> 8;
+    rr[3] = type & 0xFF;
+    rr[4] = 0;
+    rr[5] = QCLASS_IN;
+    uint32_t ttl_n = htonl(ttl);
+    memcpy(rr + 6, &ttl_n, sizeof(ttl_n));
+    rr[10] = rdlength >> 8;
+    rr[11] = rdlength & 0xFF;
+}
+
+// MINIMUM equal to TTL so negative caching lasts ttl seconds (RFC 2308)
+void write_soa_record(uint8_t* rr, uint32_t ttl) {
+    write_rr_header(rr, QTYPE_SOA, ttl, SINKHOLE_SOA_LENGTH - SINKHOLE_RR_HEADER);
+    uint8_t* rdata = rr + SINKHOLE_RR_HEADER;
+    rdata[0] = 0; // MNAME
+    rdata[1] = 0; // RNAME
+    const uint32_t soa_fields[5] = {
+        htonl(1),    // SERIAL
+        htonl(3600), // REFRESH
+        htonl(600),  // RETRY
+        htonl(86400),// EXPIRE
+        htonl(ttl),  // MINIMUM
+    };
+    memcpy(rdata + 2, soa_fields, sizeof(soa_fields));
+}
+
+void init_sinkhole_templates(sinkhole_templates& templates, uint32_t ttl) {
+    memset(&templates, 0, sizeof(templates));
+
+    write_soa_record(templates.soa, ttl);
+
+    // A 0.0.0.0 and AAAA ::, RDATA already zeroed
+    write_rr_header(templates.a, QTYPE_A, ttl, 4);
+    write_rr_header(templates.aaaa, QTYPE_AAAA, ttl, 16);
+}
+
+ssize_t build_sinkhole_response(const sinkhole_templates& templates, BLOCK_MODE mode,
+                                const dns_packet& pkt, const dns_query& query, uint8_t* response) {
+    if (query.question_end < DNS_HEADER_LENGTH || query.question_end > pkt.length)
+        return -1;
+
+    const uint8_t* record = nullptr;
+    size_t record_length = 0;
+    bool answer = false;
+    RCODE code = RCODE_NO_ERROR;
+
+    if (mode == BLOCK_MODE_NXDOMAIN) {
+        record = templates.soa;
+        record_length = sizeof(templates.soa);
+        code = RCODE_NAME_ERROR;
+    } else if (mode == BLOCK_MODE_NULL && query.qclass == QCLASS_IN && query.qtype == QTYPE_A) {
+        record = templates.a;
+        record_length = sizeof(templates.a);
+        answer = true;
+    } else if (mode == BLOCK_MODE_NULL && query.qclass == QCLASS_IN && query.qtype == QTYPE_AAAA) {
+        record = templates.aaaa;
+        record_length = sizeof(templates.aaaa);
+        answer = true;
+    } else if (mode == BLOCK_MODE_NULL) {
+        // Other types get NODATA with SOA, so clients cache the empty answer too
+        record = templates.soa;
+        record_length = sizeof(templates.soa);
+    } else {
+        return -1;
+    }
+
+    if (query.question_end + record_length > BUFFER_SIZE)
+        return -1;
+
+    // Header and question copied from query, any additional records (EDNS) dropped
+    memcpy(response, pkt.data, query.question_end);
+    memcpy(response + query.question_end, record, record_length);
+
+    // QR = 1, keep only opcode and RD, RA = 1
+    response[2] = (response[2] & 0x79) | 0x80;
+    response[3] = 0x80 | (code & 0x0F);
+    // QDCOUNT = 1, ANCOUNT or NSCOUNT = 1, ARCOUNT = 0
+    response[4] = 0; response[5] = 1;
+    response[6] = 0; response[7] = answer ? 1 : 0;
+    response[8] = 0; response[9] = answer ? 0 : 1;
+    response[10] = response[11] = 0;
+
+    return query.question_end + record_length;
+}
@@ -0,0 +1,37 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "proxy_config.hpp"
+#include "dns_structures.hpp"
+
+constexpr size_t SINKHOLE_RR_HEADER = 12;                      // NAME ptr + TYPE + CLASS + TTL + RDLENGTH
+constexpr size_t SINKHOLE_SOA_LENGTH = SINKHOLE_RR_HEADER + 22; // RDATA: MNAME + RNAME + 5x uint32
+constexpr size_t SINKHOLE_A_LENGTH = SINKHOLE_RR_HEADER + 4;
+constexpr size_t SINKHOLE_AAAA_LENGTH = SINKHOLE_RR_HEADER + 16;
+
+// Resource records prebuilt in wire format at startup, only memcpy'd per query
+struct sinkhole_templates {
+    uint8_t soa[SINKHOLE_SOA_LENGTH];
+    uint8_t a[SINKHOLE_A_LENGTH];
+    uint8_t aaaa[SINKHOLE_AAAA_LENGTH];
+};
+
+// Write IN class resource record header with owner name compressed to the question name (offset 12)
+void write_rr_header(uint8_t* rr, uint16_t type, uint32_t ttl, uint16_t rdlength);
+
+// Write SINKHOLE_SOA_LENGTH bytes of SOA record with root MNAME and RNAME, MINIMUM equal to ttl
+void write_soa_record(uint8_t* rr, uint32_t ttl);
+
+void init_sinkhole_templates(sinkhole_templates& templates, uint32_t ttl);
+
+// Build sinkhole answer for blocked query into response, returns its length or -1
+ssize_t build_sinkhole_response(const sinkhole_templates& templates, BLOCK_MODE mode,
+                                const dns_packet& pkt, const dns_query& query, uint8_t* response);
@@ -0,0 +1,166 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "socket_helper.hpp"
+
+static std::atomic<uint64_t> drops_total{0};
+
+static int get_buffer(int fd, int option) {
+    int bytes = 0;
+    socklen_t len = sizeof(bytes);
+    if (getsockopt(fd, SOL_SOCKET, option, &bytes, &len) < 0) return -1;
+    return bytes;
+}
+
+// FORCE variant ignores net.core.[rw]mem_max but needs CAP_NET_ADMIN
+static void set_buffer(int fd, int force_option, int option, int bytes) {
+    if (setsockopt(fd, SOL_SOCKET, force_option, &bytes, sizeof(bytes)) == 0) return;
+    if (setsockopt(fd, SOL_SOCKET, option, &bytes, sizeof(bytes)) < 0) perror("ERROR: setsockopt (buffer)");
+}
+
+void tune_socket(int fd, const char* name, int rcvbuf, int sndbuf, bool timestamps, bool verbose) {
+    if (rcvbuf > 0) set_buffer(fd, SO_RCVBUFFORCE, SO_RCVBUF, rcvbuf);
+    if (sndbuf > 0) set_buffer(fd, SO_SNDBUFFORCE, SO_SNDBUF, sndbuf);
+
+    int on = 1;
+    bool monitored = setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) == 0;
+    if (!monitored) perror("ERROR: setsockopt (SO_RXQ_OVFL)");
+    if (timestamps && setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0) {
+        perror("ERROR: setsockopt (SO_TIMESTAMPNS)");
+    }
+
+    // Kernel doubles requested size for bookkeeping overhead and reports doubled value
+    int effective_rcvbuf = get_buffer(fd, SO_RCVBUF);
+    int effective_sndbuf = get_buffer(fd, SO_SNDBUF);
+    if (rcvbuf > 0 && effective_rcvbuf < 2 * rcvbuf) {
+        std::cerr << "WARNING: " << name << " receive buffer limited to " << effective_rcvbuf
+                  << " bytes by net.core.rmem_max\n";
+    }
+    if (sndbuf > 0 && effective_sndbuf < 2 * sndbuf) {
+        std::cerr << "WARNING: " << name << " send buffer limited to " << effective_sndbuf
+                  << " bytes by net.core.wmem_max\n";
+    }
+
+    if (verbose) {
+        std::cout << name << " socket: receive buffer " << effective_rcvbuf << " bytes, send buffer "
+                  << effective_sndbuf << " bytes, drop monitoring " << (monitored ? "enabled" : "disabled") << "\n";
+    }
+}
+
+// Drops column of socket line matched by inode, lines are
+// "sl local rem st tx:rx tr:when retrnsmt uid timeout inode ref pointer drops"
+static bool proc_drop_counter(const char* table, ino_t inode, uint32_t& counter) {
+    std::ifstream file(table);
+    std::string line;
+    std::getline(file, line); // Header
+
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::vector<std::string> tokens;
+        for (std::string token; stream >> token;) tokens.push_back(token);
+        if (tokens.size() < 13 || tokens[9] != std::to_string(inode)) continue;
+
+        counter = static_cast<uint32_t>(std::stoul(tokens.back()));
+        return true;
+    }
+    return false;
+}
+
+void socket_stats_open(int fd, socket_stats& stats) {
+    sockaddr_storage local{};
+    socklen_t local_len = sizeof(local);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&local), &local_len);
+    bool ipv6 = local.ss_family == AF_INET6;
+    stats.name = ipv6 ? "IPv6" : "IPv4";
+
+    // Counter stays 0 when lookup fails, correct for sockets bound by this process
+    struct stat st{};
+    if (fstat(fd, &st) == 0) proc_drop_counter(ipv6 ? "/proc/net/udp6" : "/proc/net/udp", st.st_ino, stats.kernel_counter);
+}
+
+static void handle_drops(int fd, socket_stats& stats, bool grow) {
+    auto now = std::chrono::steady_clock::now();
+
+    if (grow && now - stats.last_grow >= std::chrono::seconds(SOCKET_GROW_INTERVAL)) {
+        int current = get_buffer(fd, SO_RCVBUF);
+        if (current > 0 && current < SOCKET_RCVBUF_MAX) {
+            // Requesting reported (doubled) size doubles the buffer
+            set_buffer(fd, SO_RCVBUFFORCE, SO_RCVBUF, std::min(current, SOCKET_RCVBUF_MAX / 2));
+            int grown = get_buffer(fd, SO_RCVBUF);
+            if (grown > current) {
+                std::cerr << "WARNING: " << stats.name << " receive buffer grown to " << grown << " bytes after kernel drops\n";
+            }
+        }
+        stats.last_grow = now;
+    }
+
+    if (now - stats.last_report >= std::chrono::seconds(SOCKET_REPORT_INTERVAL)) {
+        std::cerr << "WARNING: kernel dropped " << stats.drops - stats.reported << " queries on " << stats.name
+                  << " socket, " << stats.drops << " in total\n";
+        stats.reported = stats.drops;
+        stats.last_report = now;
+    }
+}
+
+ssize_t socket_receive(int fd, dns_packet& pkt, socket_stats& stats, bool grow) {
+    iovec iov{pkt.data, BUFFER_SIZE};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(timespec))];
+
+    msghdr msg{};
+    msg.msg_name = &pkt.clientAddr;
+    msg.msg_namelen = sizeof(pkt.clientAddr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t len = recvmsg(fd, &msg, MSG_DONTWAIT);
+    if (len < 0) return len;
+    pkt.clientLen = msg.msg_namelen;
+    pkt.received_ns = 0;
+
+    // Counter is attached only once socket dropped something
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) continue;
+        if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            pkt.received_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+            continue;
+        }
+        if (cmsg->cmsg_type != SO_RXQ_OVFL) continue;
+
+        uint32_t counter;
+        memcpy(&counter, CMSG_DATA(cmsg), sizeof(counter));
+        if (counter != stats.kernel_counter) {
+            stats.drops += static_cast<uint32_t>(counter - stats.kernel_counter);
+            stats.kernel_counter = counter;
+            handle_drops(fd, stats, grow);
+        }
+    }
+    return len;
+}
+
+void socket_stats_close(const socket_stats& stats) {
+    drops_total += stats.drops;
+}
+
+// Totals are collected when worker threads exit
+void print_socket_drop_stats() {
+    std::cout << "Kernel drops: " << drops_total.load() << " queries\n";
+}
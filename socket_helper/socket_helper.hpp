@@ -0,0 +1,43 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+
+#include "dns_structures.hpp"
+
+constexpr int SOCKET_RCVBUF_MAX = 16 * 1024 * 1024; // Adaptive growth stops here
+constexpr int SOCKET_GROW_INTERVAL = 1;             // Seconds between two growths
+constexpr int SOCKET_REPORT_INTERVAL = 10;          // Seconds between drop warnings
+
+// Kernel drops of one listening socket, owned by worker reading it
+struct socket_stats {
+    const char* name = "";
+    uint32_t kernel_counter = 0; // Last SO_RXQ_OVFL value, cumulative per socket, seeded at open
+    uint64_t drops = 0;          // Drops seen by this process
+    uint64_t reported = 0;       // drops at last warning
+    std::chrono::steady_clock::time_point last_report{};
+    std::chrono::steady_clock::time_point last_grow{};
+};
+
+// Apply buffer sizes (0 = kernel default), enable SO_RXQ_OVFL and SO_TIMESTAMPNS if timestamps is set,
+// logs effective values in verbose mode
+void tune_socket(int fd, const char* name, int rcvbuf, int sndbuf, bool timestamps, bool verbose);
+
+// Name stats after socket family and seed drop counter from /proc/net/udp(6), so drops seen
+// by a previous owner of an inherited socket are not reported again
+void socket_stats_open(int fd, socket_stats& stats);
+
+// recvmsg() into pkt without blocking, reads drop counter and receive timestamp from ancillary data
+// and grows receive buffer on drops
+ssize_t socket_receive(int fd, dns_packet& pkt, socket_stats& stats, bool grow);
+
+// Add drops of exiting worker to process totals
+void socket_stats_close(const socket_stats& stats);
+
+void print_socket_drop_stats();
@@ -9,9 +9,14 @@
 #include <cstdint>
 #include <netinet/in.h>
 #include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <random>
 
 constexpr int BUFFER_SIZE = 512; // Standard DNS packet size over UDP
 constexpr int DNS_HEADER_LENGTH = 12; // DNS header is always 12 bytes
+constexpr int UPSTREAM_TIMEOUT_SEC = 3; // Upstream answer deadline, SERVFAIL after
 
 struct dns_packet {
     uint8_t data[BUFFER_SIZE];
@@ -19,6 +24,7 @@ struct dns_packet {
     sockaddr_storage clientAddr;
     socklen_t clientLen;
     int sockfd = -1;
+    uint64_t received_ns = 0; // Kernel receive time (CLOCK_REALTIME) if socket timestamps are enabled, 0 otherwise
 };
 
 struct dns_query {
@@ -29,4 +35,37 @@ struct dns_query {
     uint16_t qclass = 0;
     uint16_t qtype = 0;
     uint16_t qdcount = 0;
+    uint16_t question_end = 0; // Offset right after the question section
+    uint8_t rcode = 0;            // RCODE sent back to client
+    uint32_t upstream_rtt_us = 0; // Upstream round trip, 0 if not relayed
+    uint64_t trace_start = 0;     // Receive time in ns when query is sampled for tracing
+};
+
+// Query relayed to upstream and waiting for its answer
+struct relay_slot {
+    bool in_use = false;
+    uint16_t upstream_id = 0; // Random ID used towards upstream
+    std::chrono::steady_clock::time_point sent_at;
+    dns_packet pkt;           // Original query and client address
+    dns_query query;
+};
+
+// Per-worker upstream socket with bounded number of outstanding queries
+struct relay_state {
+    int sock = -1;
+    std::vector<relay_slot> slots;
+    std::vector<uint16_t> free_slots;
+    std::vector<int16_t> id_to_slot;                     // Upstream ID -> slot, -1 unused
+    std::deque<std::pair<uint16_t, uint16_t>> deadlines; // (slot, upstream ID) in send order
+    std::mt19937 rng{std::random_device{}()};
+    size_t outstanding = 0;
+    size_t limit = 0;
+    bool overloaded = false;  // Set at limit, cleared at half of it
+    bool send_failing = false; // Set on failed send, cleared by next successful one
+
+    uint64_t relayed = 0;
+    uint64_t shed = 0;
+    uint64_t timeouts = 0;
+    uint64_t send_failures = 0;
+    size_t peak = 0;
 };
@@ -7,14 +7,35 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include <netinet/in.h>
 
+// How blocked domains are answered
+enum BLOCK_MODE {
+    BLOCK_MODE_REFUSED  = 0, // RCODE REFUSED, no records (default)
+    BLOCK_MODE_NXDOMAIN = 1, // RCODE NXDOMAIN with synthesized SOA for negative caching
+    BLOCK_MODE_NULL     = 2, // NOERROR with 0.0.0.0 (A) or :: (AAAA) answer
+};
+
 struct proxy_config {
     std::string server;      // Hostname or IP address of real DNS server
     in_addr server_ip;       // IPv4 address of real DNS server
     uint16_t port = 53;      // Default DNS port
     std::string filter_file; // Path to filter file
     bool verbose = false;    // Verbose output
+    BLOCK_MODE block_mode = BLOCK_MODE_REFUSED; // Answer for blocked domains
+    uint32_t block_ttl = 300; // TTL of synthesized sinkhole records
+    std::string query_log;   // Binary query log target, file or unix:<socket>
+    std::string xdp_pin_dir; // bpffs directory with maps pinned by xdp_filter.o
+    std::string topk_report; // File with periodic top queried/blocked names and clients
+    std::string handoff_socket; // UNIX socket for passing listening sockets to restarted process
+    uint16_t max_outstanding = 256; // Upstream queries in flight per worker before shedding
+    std::string local_zone;  // Hosts or zone file with names answered locally
+    std::string trace_file;  // Chrome trace event JSON with spans of sampled queries
+    uint32_t trace_sample = 100; // Trace one of every N queries
+    int rcvbuf = 0;          // SO_RCVBUF of listening sockets, 0 = kernel default
+    int sndbuf = 0;          // SO_SNDBUF of listening sockets, 0 = kernel default
+    bool grow_rcvbuf = false; // Double receive buffer when kernel drops queries
 };
 
 struct upstream_server {
@@ -0,0 +1,72 @@
+import os
+import socket
+import struct
+import threading
+
+import pytest
+
+# Makefile passes binary of selected build variant
+TARGET = os.environ.get("DNS_BINARY", "./dns")
+
+class FakeUpstream:
+    """Upstream on 127.0.0.1:53 recording query names, answers A queries with 192.0.2.1 unless silent.
+
+    Raises OSError when port cannot be bound (needs root).
+    """
+
+    def __init__(self, answer=True):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        try:
+            self.sock.bind(("127.0.0.1", 53))
+        except OSError:
+            self.sock.close()
+            raise
+        self.sock.settimeout(0.1)
+        self.answer = answer
+        self.names = []
+        self.stop = threading.Event()
+        self.thread = threading.Thread(target=self.serve, daemon=True)
+        self.thread.start()
+
+    def serve(self):
+        while not self.stop.is_set():
+            try:
+                data, addr = self.sock.recvfrom(512)
+            except socket.timeout:
+                continue
+            end = 12
+            labels = []
+            while end < len(data) and data[end]:
+                labels.append(data[end + 1:end + 1 + data[end]].decode(errors="replace"))
+                end += 1 + data[end]
+            self.names.append(".".join(labels))
+            if not self.answer:
+                continue
+            answer = b"\xc0\x0c" + struct.pack(">HHIH", 1, 1, 60, 4) + bytes([192, 0, 2, 1])
+            self.sock.sendto(data[:2] + b"\x81\x80" + data[4:6] + b"\x00\x01\x00\x00\x00\x00" +
+                             data[12:end + 5] + answer, addr)
+
+    def close(self):
+        self.stop.set()
+        self.thread.join()
+        self.sock.close()
+
+def fake_upstream_or_skip(answer):
+    try:
+        return FakeUpstream(answer)
+    except OSError:
+        pytest.skip("cannot bind fake upstream on 127.0.0.1:53")
+
+@pytest.fixture
+def upstream():
+    """Answering fake upstream, skips test when port 53 cannot be bound."""
+    fake = fake_upstream_or_skip(True)
+    yield fake
+    fake.close()
+
+@pytest.fixture
+def silent_upstream():
+    """Fake upstream that never answers, skips test when port 53 cannot be bound."""
+    fake = fake_upstream_or_skip(False)
+    yield fake
+    fake.close()
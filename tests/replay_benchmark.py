@@ -0,0 +1,129 @@
+"""Reproducible local replay workload for PGO training and build variant comparison.
+
+Starts the proxy on a local port with a generated filter list, replays a seeded mix of
+allowed, blocked, unsupported and malformed queries and prints throughput and latency.
+Allowed A queries are relayed to a fake upstream on 127.0.0.1:53 when it can be bound
+(needs root), otherwise they are left out of the mix.
+"""
+
+import argparse
+import os
+import random
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+from conftest import FakeUpstream
+
+SEED = 2025
+FILTER_RULES = 20000
+HOT_NAMES = 2000
+WINDOW = 16
+
+
+def encode_query(qid, name, qtype):
+    qname = b"".join(bytes([len(label)]) + label.encode() for label in name.split(".")) + b"\0"
+    return struct.pack(">HHHHHH", qid, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", qtype, 1)
+
+
+def build_workload(count, with_relay):
+    rng = random.Random(SEED)
+    blocked = [f"ads{i}.tracker{i % 97}.com" for i in range(FILTER_RULES)]
+    allowed = [f"host{i}.example{i % 13}.org" for i in range(HOT_NAMES)]
+
+    queries = []
+    for qid in range(count):
+        pick = rng.random()
+        if pick < 0.30:
+            # Blocked, half of them as subdomain of a rule
+            name = rng.choice(blocked[:HOT_NAMES])
+            if rng.random() < 0.5:
+                name = "www." + name
+            queries.append(encode_query(qid & 0xFFFF, name, 1))
+        elif pick < 0.45:
+            queries.append(encode_query(qid & 0xFFFF, rng.choice(allowed), 28))  # NOTIMP
+        elif pick < 0.50:
+            # FORMERR, label longer than packet
+            queries.append(struct.pack(">HHHHHH", qid & 0xFFFF, 0x0100, 1, 0, 0, 0) + b"\x3fads")
+        elif pick < 0.60:
+            # Long tail of names seen once, misses verdict cache
+            queries.append(encode_query(qid & 0xFFFF, f"tail{qid}.cdn{qid % 31}.net", 28))
+        elif with_relay:
+            queries.append(encode_query(qid & 0xFFFF, rng.choice(allowed), 1))
+        else:
+            queries.append(encode_query(qid & 0xFFFF, rng.choice(allowed), 15))  # NOTIMP
+    return blocked, queries
+
+
+def replay(queries, port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    latencies = []
+    lost = 0
+
+    start = time.perf_counter()
+    for i in range(0, len(queries), WINDOW):
+        batch = queries[i:i + WINDOW]
+        sent = {}
+        for q in batch:
+            sent[q[:2]] = time.perf_counter()
+            sock.sendto(q, ("127.0.0.1", port))
+        for _ in batch:
+            try:
+                data = sock.recv(512)
+            except socket.timeout:
+                lost += len(sent)
+                break
+            t = sent.pop(data[:2], None)
+            if t is not None:
+                latencies.append(time.perf_counter() - t)
+    elapsed = time.perf_counter() - start
+    return elapsed, sorted(latencies), lost
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--binary", default="./dns")
+    parser.add_argument("--queries", type=int, default=20000)
+    parser.add_argument("--port", type=int, default=5399)
+    args = parser.parse_args()
+
+    try:
+        upstream = FakeUpstream()
+    except OSError:
+        print("WARNING: cannot bind fake upstream on 127.0.0.1:53, relayed queries left out")
+        upstream = None
+    with_relay = upstream is not None
+
+    blocked, queries = build_workload(args.queries, with_relay)
+    with tempfile.NamedTemporaryFile(mode="w", delete=False) as f:
+        f.write("\n".join(blocked) + "\n")
+
+    proxy = subprocess.Popen([args.binary, "-s", "127.0.0.1", "-p", str(args.port), "-f", f.name],
+                             stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    time.sleep(0.5)
+
+    try:
+        elapsed, latencies, lost = replay(queries, args.port)
+    finally:
+        # SIGINT lets the proxy exit normally, so instrumented builds write their profile
+        proxy.send_signal(signal.SIGINT)
+        _, _, usage = os.wait4(proxy.pid, 0)
+        if upstream:
+            upstream.close()
+        os.unlink(f.name)
+
+    answered = len(latencies)
+    p50 = latencies[answered // 2] * 1e6 if answered else 0
+    p99 = latencies[int(answered * 0.99)] * 1e6 if answered else 0
+    # Proxy CPU time does not depend on speed of this Python client
+    cpu = (usage.ru_utime + usage.ru_stime) / max(answered, 1) * 1e6
+    print(f"{args.binary}: {answered} answered, {lost} lost, {answered / elapsed:.0f} qps, "
+          f"p50 {p50:.0f} us, p99 {p99:.0f} us, proxy cpu {cpu:.1f} us/query")
+
+
+if __name__ == "__main__":
+    main()
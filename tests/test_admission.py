@@ -0,0 +1,83 @@
+import os
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+from conftest import TARGET
+
+PORT = 5324
+LIMIT = 5
+QUERIES = 8
+UPSTREAM_TIMEOUT = 3
+
+def encode_query(qid, name):
+    qname = b"".join(bytes([len(label)]) + label.encode() for label in name.split(".")) + b"\0"
+    return struct.pack(">HHHHHH", qid, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", 1, 1)
+
+def collect(sock, deadline):
+    """Return {id: rcode} of answers received until deadline."""
+    answers = {}
+    while time.time() < deadline:
+        sock.settimeout(max(deadline - time.time(), 0.01))
+        try:
+            resp = sock.recv(512)
+        except socket.timeout:
+            break
+        qid, flags = struct.unpack(">HH", resp[:4])
+        answers[qid] = flags & 0x0F
+    return answers
+
+def read_verdicts(path):
+    """Return {id: (verdict, rcode)} of query log records."""
+    with open(path, "rb") as log:
+        data = log.read()
+    assert data[:8] == b"DNSQLOG\x01"
+    verdicts, offset = {}, 8
+    while offset < len(data):
+        length = struct.unpack(">H", data[offset:offset + 2])[0]
+        record = data[offset:offset + 2 + length]
+        verdicts[struct.unpack(">H", record[20:22])[0]] = (record[3], record[22])
+        offset += 2 + length
+    return verdicts
+
+def test_queries_over_limit_are_shed(silent_upstream):
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+    log_path = tempfile.mktemp(suffix=".qlog")
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", f.name, "-q", str(LIMIT), "-l", log_path, "-v"],
+        stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True
+    )
+    time.sleep(0.3)
+
+    client = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        for qid in range(1, QUERIES + 1):
+            client.sendto(encode_query(qid, f"q{qid}.example.org"), ("127.0.0.1", PORT))
+
+        # Queries over limit fail fast, in-flight ones wait for upstream
+        shed = collect(client, time.time() + 1)
+        assert shed == {qid: 2 for qid in range(LIMIT + 1, QUERIES + 1)}
+
+        # In-flight queries expire with SERVFAIL
+        expired = collect(client, time.time() + UPSTREAM_TIMEOUT + 1)
+        assert expired == {qid: 2 for qid in range(1, LIMIT + 1)}
+
+        assert len(silent_upstream.names) == LIMIT
+    finally:
+        client.close()
+        proc.send_signal(signal.SIGINT)
+        out, err = proc.communicate(timeout=5)
+        os.unlink(f.name)
+
+    assert "shedding new queries (5 outstanding)" in err
+    # Shed queries are told apart from upstream failures in query log
+    verdicts = read_verdicts(log_path)
+    os.unlink(log_path)
+    assert verdicts == {qid: (5, 2) if qid > LIMIT else (0, 2) for qid in range(1, QUERIES + 1)}
+
+    assert f"Upstream: {LIMIT} relayed, {QUERIES - LIMIT} shed, {LIMIT} timed out, 0 send failures, peak {LIMIT}/{LIMIT}" in out
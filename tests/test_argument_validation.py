@@ -1,7 +1,7 @@
 import subprocess
-import os
+import signal
 
-TARGET = "./dns"
+from conftest import TARGET
 
 def run_dns(args):
     """Run the dns binary with specified args and return stdout and stderr."""
@@ -11,7 +11,12 @@ def run_dns(args):
         stderr=subprocess.PIPE,
         text=True
     )
-    stdout, stderr = process.communicate()
+    try:
+        stdout, stderr = process.communicate(timeout=1)
+    except subprocess.TimeoutExpired:
+        # Bind on port 53 succeeds as root and proxy keeps running, warnings are printed by now
+        process.send_signal(signal.SIGINT)
+        stdout, stderr = process.communicate(timeout=5)
     return stdout, stderr, process.returncode
 
 def test_missing_server():
@@ -43,3 +48,28 @@ def test_valid_args():
     assert "ERROR: unknown" not in stderr
     assert "contains non-numeric characters" not in stderr
 
+
+def test_invalid_block_mode():
+    _, stderr, _ = run_dns(["-s", "8.8.8.8", "-f", "filter.txt", "-b", "drop"])
+    assert "is not one of refused/nxdomain/null" in stderr
+
+def test_invalid_block_ttl():
+    _, stderr, _ = run_dns(["-s", "8.8.8.8", "-f", "filter.txt", "-b", "null", "-t", "-5"])
+    assert "Using default 300" in stderr
+
+def test_invalid_max_outstanding():
+    _, stderr, _ = run_dns(["-s", "8.8.8.8", "-f", "filter.txt", "-q", "0"])
+    assert "Using default 256" in stderr
+
+def test_invalid_trace_sample():
+    _, stderr, _ = run_dns(["-s", "8.8.8.8", "-f", "filter.txt", "-n", "abc"])
+    assert "Using default 100" in stderr
+
+def test_invalid_buffer_size():
+    _, stderr, _ = run_dns(["-s", "8.8.8.8", "-f", "filter.txt", "-i", "100"])
+    assert "Using kernel default" in stderr
+
+def test_query_log_unwritable():
+    _, stderr, code = run_dns(["-s", "8.8.8.8", "-f", "filter.txt", "-l", "/nonexistent/dir/query.log"])
+    assert "query log" in stderr
+    assert code != 0
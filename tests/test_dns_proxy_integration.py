@@ -4,7 +4,7 @@ import time
 import os
 import signal
 
-TARGET = "./dns"
+from conftest import TARGET
 
 def start_dns_proxy(filter_content, port=5300):
     # Create temporary filter file
@@ -1,9 +1,16 @@
 import subprocess
 import tempfile
 import os
+import shutil
+import signal
+import socket
+import struct
 import sys
+import time
 
-TARGET = "./dns"
+import pytest
+
+from conftest import TARGET
 
 def capture_output(command):
     """Execute a command and capture stdout and stderr."""
@@ -13,9 +20,23 @@ def capture_output(command):
         stderr=subprocess.PIPE,
         text=True
     )
-    stdout, stderr = process.communicate()
+    try:
+        stdout, stderr = process.communicate(timeout=1)
+    except subprocess.TimeoutExpired:
+        # Bind on port 53 succeeds as root and proxy keeps running, filters are loaded by now
+        process.send_signal(signal.SIGINT)
+        stdout, stderr = process.communicate(timeout=5)
     return stdout, stderr, process.returncode
 
+def run_proxy_briefly(args, port):
+    """Start proxy on test port, stop it with SIGINT once started and return its output."""
+    proc = subprocess.Popen([TARGET, "-s", "127.0.0.1", "-p", str(port), *args],
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    time.sleep(0.3)
+    proc.send_signal(signal.SIGINT)
+    stdout, stderr = proc.communicate(timeout=5)
+    return stdout, stderr
+
 def write_temp_file(lines):
     """Create a temporary file with the provided lines."""
     temp = tempfile.NamedTemporaryFile(mode="w+", delete=False)
@@ -77,3 +98,98 @@ def test_is_blocked():
     
     # Cleanup
     os.unlink(filename)
+
+def test_filter_storage_report():
+    # Duplicates and shared parent domains are stored once
+    filter_domains = ["ads.example.com", "track.example.com", "ads.example.com", "example.com"]
+    filename = write_temp_file(filter_domains)
+
+    stdout, _ = run_proxy_briefly(["-f", filename, "-v"], 5329)
+
+    assert "Loaded 3 filter rules" in stdout
+    assert "4 labels, 4 nodes" in stdout
+    assert "bytes per rule" in stdout
+
+    os.unlink(filename)
+
+def test_leading_dot_label_not_blocked():
+    # Wire label "\x04.com" reads as ".com", must not match rule one level deeper
+    filename = write_temp_file(["com.com"])
+    proc = subprocess.Popen([TARGET, "-s", "127.0.0.1", "-p", "5325", "-f", filename],
+                            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    time.sleep(0.3)
+
+    rcodes = []
+    try:
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.settimeout(1)
+        # MX is answered locally, NOTIMP when allowed, REFUSED when blocked
+        for qname in (b"\x04.com\x00", b"\x03com\x03com\x00"):
+            sock.sendto(struct.pack(">HHHHHH", 1, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", 15, 1),
+                        ("127.0.0.1", 5325))
+            rcodes.append(struct.unpack(">H", sock.recv(512)[2:4])[0] & 0x0F)
+        sock.close()
+    finally:
+        proc.send_signal(signal.SIGINT)
+        proc.wait(timeout=2)
+        os.unlink(filename)
+
+    assert rcodes == [4, 5]
+
+# Links filter_helper directly, verdict cache has no observable output in the proxy
+CACHE_DRIVER = r"""
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "filter_helper.hpp"
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> names = {
+        "ads.example.com", "www.ads.example.com", "example.com", "com", "ads.example.org",
+        "tracker.net", "x.tracker.net", "tracker.net.evil", std::string(80, 'a') + ".tracker.net",
+    };
+    int mismatches = 0;
+    for (int file = 1; file < argc; ++file) {
+        filter_set rules = load_filters(argv[file], false);
+        // Cold pass fills cache, warm pass hits it, both must agree with uncached lookup
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const auto& name : names) {
+                bool expected = is_blocked(name, rules);
+                bool cached = is_blocked_cached(name, rules);
+                if (cached != expected) {
+                    printf("MISMATCH file %d pass %d %s\n", file, pass, name.c_str());
+                    mismatches++;
+                }
+                printf("%d", cached);
+            }
+            printf("\n");
+        }
+    }
+    return mismatches;
+}
+"""
+
+def test_verdict_cache_matches_uncached():
+    compiler = shutil.which("g++")
+    if not compiler:
+        pytest.skip("needs g++")
+
+    workdir = tempfile.mkdtemp()
+    source = os.path.join(workdir, "cache_driver.cpp")
+    binary = os.path.join(workdir, "cache_driver")
+    with open(source, "w") as f:
+        f.write(CACHE_DRIVER)
+    repo = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    subprocess.check_call([compiler, "-std=c++17", "-I", os.path.join(repo, "filter_helper"), source,
+                           os.path.join(repo, "filter_helper", "filter_helper.cpp"), "-o", binary])
+
+    # Second load bumps filter generation, verdicts cached for first set must not survive
+    first = write_temp_file(["ads.example.com"])
+    second = write_temp_file(["example.com", "tracker.net"])
+    stdout, _, code = capture_output([binary, first, second])
+
+    assert code == 0, stdout
+    assert stdout.split() == ["110000000", "110000000", "111001101", "111001101"]
+
+    os.unlink(first)
+    os.unlink(second)
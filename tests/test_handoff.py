@@ -0,0 +1,102 @@
+import os
+import signal
+import socket
+import stat
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+import pytest
+
+from conftest import TARGET
+
+PORT = 5323
+
+def start_dns_proxy(filter_file, handoff_path):
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", filter_file, "-u", handoff_path],
+        stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True
+    )
+    time.sleep(0.5)
+    return proc
+
+def blocked_query():
+    """Blocked name is answered locally with REFUSED, no upstream needed."""
+    qname = b"\x03ads\x07example\x03com\x00"
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    sock.sendto(struct.pack(">HHHHHH", 0x4242, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", 1, 1),
+                ("127.0.0.1", PORT))
+    resp = sock.recv(512)
+    sock.close()
+    qid, flags = struct.unpack(">HH", resp[:4])
+    return qid, flags & 0x0F
+
+def make_filter():
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+    return f.name
+
+def test_handoff_to_new_process():
+    filter_file = make_filter()
+    handoff_path = tempfile.mktemp(suffix=".sock")
+    old = start_dns_proxy(filter_file, handoff_path)
+    new = None
+    try:
+        assert blocked_query() == (0x4242, 5)
+        assert stat.S_IMODE(os.stat(handoff_path).st_mode) == 0o600
+
+        # New process takes over sockets, old one exits on its own
+        new = start_dns_proxy(filter_file, handoff_path)
+        out, _ = old.communicate(timeout=5)
+        assert old.returncode == 0
+        assert "Sockets handed over to new process" in out
+
+        assert blocked_query() == (0x4242, 5)
+        assert new.poll() is None
+    finally:
+        for proc in (old, new):
+            if proc and proc.poll() is None:
+                proc.send_signal(signal.SIGINT)
+                proc.communicate(timeout=5)
+        os.unlink(filter_file)
+        if os.path.exists(handoff_path):
+            os.unlink(handoff_path)
+
+# Connects as another user and reports number of received bytes and descriptors
+FOREIGN_CLIENT = """
+import array, os, socket, sys
+os.setgid(65534)
+os.setuid(65534)
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect(sys.argv[1])
+data, ancdata, _, _ = s.recvmsg(1, socket.CMSG_SPACE(8))
+fds = sum(len(c[2]) // 4 for c in ancdata if c[1] == socket.SCM_RIGHTS)
+print(len(data), fds)
+"""
+
+@pytest.mark.skipif(os.geteuid() != 0, reason="needs root to connect as another user")
+def test_handoff_refuses_other_user():
+    filter_file = make_filter()
+    handoff_path = tempfile.mktemp(suffix=".sock")
+    proc = start_dns_proxy(filter_file, handoff_path)
+    try:
+        # Open the socket up so only the peer credential check stands in the way
+        os.chmod(handoff_path, 0o666)
+        client = subprocess.run([sys.executable, "-c", FOREIGN_CLIENT, handoff_path],
+                                capture_output=True, text=True, timeout=5)
+        assert client.stdout.split() == ["0", "0"]
+
+        # Still serving
+        assert blocked_query() == (0x4242, 5)
+        assert proc.poll() is None
+    finally:
+        proc.send_signal(signal.SIGINT)
+        _, err = proc.communicate(timeout=5)
+        os.unlink(filter_file)
+        if os.path.exists(handoff_path):
+            os.unlink(handoff_path)
+    assert "handoff refused" in err
@@ -0,0 +1,109 @@
+import os
+import shutil
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+import pytest
+
+from conftest import TARGET
+
+PORT = 5326
+ZONE = "10.0.0.5 nas.home.lan\nweb.home.lan 60 IN AAAA fd00::80\n" + \
+       "".join(f"10.1.0.{i} big.home.lan\n" for i in range(1, 41))
+
+def start_dns_proxy():
+    zone = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    zone.write(ZONE)
+    zone.close()
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.close()
+
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", f.name, "-z", zone.name],
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    time.sleep(0.3)
+    return proc, [zone.name, f.name]
+
+def stop_dns_proxy(proc, files):
+    proc.send_signal(signal.SIGINT)
+    proc.wait(timeout=5)
+    for name in files:
+        os.unlink(name)
+
+def query(name, qtype):
+    qname = b"".join(bytes([len(label)]) + label.encode() for label in name.split(".")) + b"\0"
+    pkt = struct.pack(">HHHHHH", 0x5151, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", qtype, 1)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    sock.sendto(pkt, ("127.0.0.1", PORT))
+    resp = sock.recv(4096)
+    sock.close()
+    flags, qd, an, ns, ar = struct.unpack(">HHHHH", resp[2:12])
+    return resp, len(pkt), flags, an, ns
+
+def dig_query(name, query_type="A"):
+    cmd = ["dig", "@127.0.0.1", "-p", str(PORT), name, query_type, "+short", "+retry=0", "+time=1", "+notcp"]
+    return subprocess.run(cmd, capture_output=True, text=True, timeout=3).stdout.strip()
+
+@pytest.mark.skipif(not shutil.which("dig"), reason="needs dig")
+def test_local_zone(upstream):
+    proc, files = start_dns_proxy()
+    try:
+        assert dig_query("nas.home.lan") == "10.0.0.5"
+        assert dig_query("web.home.lan", query_type="AAAA") == "fd00::80"
+        assert dig_query("web.home.lan") == ""  # Local name without A record, NODATA
+        assert dig_query("other.example.org") == "192.0.2.1"
+    finally:
+        stop_dns_proxy(proc, files)
+
+    # Only the name missing from local zone went upstream
+    assert upstream.names == ["other.example.org"]
+
+def test_local_names_not_relayed(upstream):
+    proc, files = start_dns_proxy()
+    try:
+        # Answer, NODATA, truncated answer and NODATA of unsupported type all stay local
+        for name, qtype in (("nas.home.lan", 1), ("web.home.lan", 1), ("big.home.lan", 1), ("nas.home.lan", 15)):
+            _, _, flags, _, _ = query(name, qtype)
+            assert flags & 0x0F == 0 and flags & 0x0400
+        _, _, flags, an, _ = query("other.example.org", 1)
+        assert flags & 0x0F == 0 and an == 1
+    finally:
+        stop_dns_proxy(proc, files)
+
+    assert upstream.names == ["other.example.org"]
+
+def test_nodata_carries_soa():
+    proc, files = start_dns_proxy()
+    try:
+        resp, qend, flags, an, ns = query("web.home.lan", 1)
+    finally:
+        stop_dns_proxy(proc, files)
+
+    assert flags & 0x0F == 0 and flags & 0x0400  # NOERROR, AA
+    assert (an, ns) == (0, 1)
+    assert resp[qend:qend + 2] == b"\xc0\x0c"
+    rtype, rclass, ttl, rdlength = struct.unpack(">HHIH", resp[qend + 2:qend + 12])
+    assert (rtype, rclass, ttl, rdlength) == (6, 1, 300, 22)
+    # Root MNAME and RNAME, MINIMUM bounds negative caching
+    assert resp[qend + 12:qend + 14] == b"\0\0"
+    assert struct.unpack(">IIIII", resp[qend + 14:qend + 34])[4] == 300
+
+def test_oversized_answer_truncated():
+    proc, files = start_dns_proxy()
+    try:
+        # 40 A records take 640 bytes, more than fits into 512 byte UDP message
+        resp, qend, flags, an, ns = query("big.home.lan", 1)
+    finally:
+        stop_dns_proxy(proc, files)
+
+    assert flags & 0x0200  # TC
+    assert flags & 0x0F == 0 and ns == 0
+    assert an == (512 - qend) // 16 and len(resp) == qend + an * 16
+    addresses = {socket.inet_ntoa(resp[qend + 16 * i + 12:qend + 16 * i + 16]) for i in range(an)}
+    assert addresses <= {f"10.1.0.{i}" for i in range(1, 41)} and len(addresses) == an
@@ -0,0 +1,98 @@
+import os
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+from conftest import TARGET
+
+PORT = 5321
+MAGIC = b"DNSQLOG\x01"
+RECORD_HEADER = 43
+
+def run_proxy_with_queries(log_path, queries):
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", f.name, "-l", log_path],
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    time.sleep(0.3)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    for qid, name, qtype in queries:
+        qname = b"".join(bytes([len(label)]) + label.encode() for label in name.split(".")) + b"\0"
+        sock.sendto(struct.pack(">HHHHHH", qid, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", qtype, 1),
+                    ("127.0.0.1", PORT))
+        sock.recv(512)
+    client_port = sock.getsockname()[1]
+    sock.close()
+
+    # Writer flushes buffered records on exit
+    proc.send_signal(signal.SIGINT)
+    proc.wait(timeout=3)
+    os.unlink(f.name)
+    return client_port
+
+def read_records(data):
+    records = []
+    offset = 0
+    while offset < len(data):
+        length = struct.unpack(">H", data[offset:offset + 2])[0]
+        record = data[offset:offset + 2 + length]
+        (version, verdict, timestamp, rtt, qtype, qclass, qid, rcode, family, port) = \
+            struct.unpack(">BBQIHHHBBH", record[2:26])
+        qname_length = record[42]
+        assert length + 2 == RECORD_HEADER + qname_length
+        records.append({
+            "version": version, "verdict": verdict, "timestamp": timestamp, "rtt": rtt,
+            "qtype": qtype, "qclass": qclass, "id": qid, "rcode": rcode, "family": family,
+            "port": port, "address": record[26:42], "qname": record[43:].decode(),
+        })
+        offset += 2 + length
+    return records
+
+def test_query_log_records():
+    log_path = tempfile.mktemp(suffix=".qlog")
+    before = int(time.time() * 1e6)
+    client_port = run_proxy_with_queries(log_path, [(0x0101, "ads.example.com", 1), (0x0202, "Other.Example.org", 15)])
+
+    with open(log_path, "rb") as f:
+        data = f.read()
+    os.unlink(log_path)
+
+    assert data[:8] == MAGIC
+    records = read_records(data[8:])
+    assert len(records) == 2
+
+    blocked, notimp = records
+    assert blocked["version"] == 1
+    assert blocked["verdict"] == 1 and blocked["rcode"] == 5
+    assert blocked["qname"] == "ads.example.com"
+    assert (blocked["qtype"], blocked["qclass"], blocked["id"]) == (1, 1, 0x0101)
+    assert blocked["rtt"] == 0
+    assert blocked["family"] == 4 and blocked["port"] == client_port
+    assert blocked["address"] == b"\x7f\x00\x00\x01" + b"\0" * 12
+    assert before <= blocked["timestamp"] <= notimp["timestamp"] <= int(time.time() * 1e6)
+
+    assert notimp["verdict"] == 2 and notimp["rcode"] == 4
+    assert notimp["qname"] == "Other.Example.org"
+    assert (notimp["qtype"], notimp["id"]) == (15, 0x0202)
+
+def test_query_log_append_without_magic():
+    log_path = tempfile.mktemp(suffix=".qlog")
+    run_proxy_with_queries(log_path, [(1, "ads.example.com", 1)])
+    run_proxy_with_queries(log_path, [(2, "ads.example.com", 1)])
+
+    with open(log_path, "rb") as f:
+        data = f.read()
+    os.unlink(log_path)
+
+    # Magic only at start of file, second run appends records only
+    assert data.count(MAGIC) == 1 and data[:8] == MAGIC
+    assert [r["id"] for r in read_records(data[8:])] == [1, 2]
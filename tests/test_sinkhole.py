@@ -0,0 +1,97 @@
+import os
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+from conftest import TARGET
+
+PORT = 5320
+TTL = 123
+
+def start_dns_proxy(mode):
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", f.name, "-b", mode, "-t", str(TTL)],
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    time.sleep(0.3)
+    return proc, f.name
+
+def stop_dns_proxy(proc, filter_file):
+    proc.send_signal(signal.SIGINT)
+    proc.wait(timeout=2)
+    os.unlink(filter_file)
+
+def query(name, qtype):
+    qname = b"".join(bytes([len(label)]) + label.encode() for label in name.split(".")) + b"\0"
+    pkt = struct.pack(">HHHHHH", 0x1234, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", qtype, 1)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    sock.sendto(pkt, ("127.0.0.1", PORT))
+    resp = sock.recv(512)
+    sock.close()
+    return resp, len(pkt)
+
+def parse(resp, question_end):
+    """Return header fields and the single record following the question."""
+    qid, flags, qd, an, ns, ar = struct.unpack(">HHHHHH", resp[:12])
+    record = None
+    if an + ns:
+        rtype, rclass, ttl, rdlength = struct.unpack(">HHIH", resp[question_end + 2:question_end + 12])
+        assert resp[question_end:question_end + 2] == b"\xc0\x0c"  # Owner compressed to question
+        rdata = resp[question_end + 12:question_end + 12 + rdlength]
+        record = (rtype, rclass, ttl, rdata)
+    return qid, flags & 0x0F, an, ns, ar, record
+
+def test_refused_mode():
+    proc, filter_file = start_dns_proxy("refused")
+    try:
+        resp, qend = query("ads.example.com", 1)
+        qid, rcode, an, ns, _, _ = parse(resp, qend)
+        assert qid == 0x1234
+        assert rcode == 5
+        assert an == 0 and ns == 0
+    finally:
+        stop_dns_proxy(proc, filter_file)
+
+def test_nxdomain_mode():
+    proc, filter_file = start_dns_proxy("nxdomain")
+    try:
+        resp, qend = query("www.ads.example.com", 1)
+        _, rcode, an, ns, ar, record = parse(resp, qend)
+        assert rcode == 3
+        assert (an, ns, ar) == (0, 1, 0)
+        rtype, rclass, ttl, rdata = record
+        assert (rtype, rclass, ttl) == (6, 1, TTL)
+        # Root MNAME and RNAME, then SERIAL REFRESH RETRY EXPIRE MINIMUM
+        assert rdata[:2] == b"\0\0"
+        assert struct.unpack(">IIIII", rdata[2:])[4] == TTL
+    finally:
+        stop_dns_proxy(proc, filter_file)
+
+def test_null_mode():
+    proc, filter_file = start_dns_proxy("null")
+    try:
+        resp, qend = query("ads.example.com", 1)
+        _, rcode, an, ns, _, record = parse(resp, qend)
+        assert rcode == 0 and (an, ns) == (1, 0)
+        assert record == (1, 1, TTL, b"\0" * 4)
+
+        resp, qend = query("ads.example.com", 28)
+        _, rcode, an, ns, _, record = parse(resp, qend)
+        assert rcode == 0 and (an, ns) == (1, 0)
+        assert record == (28, 1, TTL, b"\0" * 16)
+
+        # Other types get NODATA with SOA
+        resp, qend = query("ads.example.com", 15)
+        _, rcode, an, ns, _, record = parse(resp, qend)
+        assert rcode == 0 and (an, ns) == (0, 1)
+        assert record[0] == 6 and record[2] == TTL
+    finally:
+        stop_dns_proxy(proc, filter_file)
@@ -0,0 +1,122 @@
+import os
+import re
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+from conftest import TARGET
+
+PORT = 5328
+BLOCKED = struct.pack(">HHHHHH", 1, 0x0100, 1, 0, 0, 0) + b"\x03ads\x07example\x03com\x00" + struct.pack(">HH", 1, 1)
+
+def start_dns_proxy(filter_file, *extra_args):
+    # Verbose output of every query goes to files, a full pipe would stall the worker
+    out = tempfile.TemporaryFile(mode="w+")
+    err = tempfile.TemporaryFile(mode="w+")
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", filter_file, "-v", *extra_args],
+        stdout=out, stderr=err, text=True
+    )
+    proc.output = (out, err)
+    time.sleep(0.3)
+    return proc
+
+def read_output(proc):
+    proc.wait(timeout=5)
+    texts = []
+    for f in proc.output:
+        f.seek(0)
+        texts.append(f.read())
+        f.close()
+    return texts
+
+def stop_dns_proxy(proc):
+    proc.send_signal(signal.SIGINT)
+    return read_output(proc)
+
+def make_filter():
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+    return f.name
+
+def flood(count):
+    """Send burst far faster than worker answers, replies are never read."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    for _ in range(count):
+        sock.sendto(BLOCKED, ("127.0.0.1", PORT))
+    sock.close()
+
+def answered(count):
+    """Send queries one at a time, returns number answered."""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    replies = 0
+    for _ in range(count):
+        sock.sendto(BLOCKED, ("127.0.0.1", PORT))
+        try:
+            sock.recv(512)
+            replies += 1
+        except socket.timeout:
+            pass
+    sock.close()
+    return replies
+
+def kernel_drops(out):
+    return int(re.search(r"Kernel drops: (\d+) queries", out).group(1))
+
+def test_buffer_sizes_reported():
+    filter_file = make_filter()
+    proc = start_dns_proxy(filter_file, "-i", "65536", "-o", "65536")
+    out, err = stop_dns_proxy(proc)
+    os.unlink(filter_file)
+
+    # Kernel reports double of requested size
+    assert "IPv4 socket: receive buffer 131072 bytes, send buffer 131072 bytes, drop monitoring enabled" in out
+    assert "limited" not in err
+
+def test_kernel_drops_reported():
+    filter_file = make_filter()
+    proc = start_dns_proxy(filter_file, "-i", "4096")
+    try:
+        # First burst overflows small buffer, next query carries the drop counter
+        flood(5000)
+        time.sleep(0.5)
+        assert answered(5) == 5
+    finally:
+        out, err = stop_dns_proxy(proc)
+        os.unlink(filter_file)
+
+    assert re.search(r"WARNING: kernel dropped \d+ queries on IPv4 socket", err)
+    assert kernel_drops(out) > 0
+
+def test_inherited_drops_not_counted_again():
+    filter_file = make_filter()
+    handoff_path = tempfile.mktemp(suffix=".sock")
+    old = start_dns_proxy(filter_file, "-i", "4096", "-u", handoff_path)
+    new = None
+    try:
+        flood(5000)
+        time.sleep(0.5)
+        assert answered(5) == 5
+
+        new = start_dns_proxy(filter_file, "-u", handoff_path)
+        old_out, _ = read_output(old)
+        assert kernel_drops(old_out) > 0
+
+        # New process starts from inherited counter, quiet traffic adds no drops
+        assert answered(5) == 5
+    finally:
+        if old.poll() is None:
+            stop_dns_proxy(old)
+        if new:
+            new_out, new_err = stop_dns_proxy(new)
+        os.unlink(filter_file)
+        if os.path.exists(handoff_path):
+            os.unlink(handoff_path)
+
+    assert kernel_drops(new_out) == 0
+    assert "kernel dropped" not in new_err
@@ -0,0 +1,141 @@
+import os
+import re
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+import pytest
+
+from conftest import TARGET
+
+PORT = 5322
+DUMP_INTERVAL = 10
+HEADERS = ["# Top queried names (count, max overestimation)",
+           "# Top blocked names (count, max overestimation)",
+           "# Top clients (count, max overestimation)"]
+LINE = re.compile(r"^ *(\d+)  \(\+(\d+)\)  (\S+)$")
+
+def start_dns_proxy(report_path):
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", f.name, "-k", report_path],
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    time.sleep(0.3)
+    return proc, f.name
+
+def send_queries(family, address, names):
+    """Blocked and MX queries are answered locally, no upstream needed."""
+    sock = socket.socket(family, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    for name in names:
+        qname = b"".join(bytes([len(label)]) + label.encode() for label in name.split(".")) + b"\0"
+        sock.sendto(struct.pack(">HHHHHH", 0x1234, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", 15, 1),
+                    (address, PORT))
+        sock.recv(512)
+    sock.close()
+
+def ipv6_available():
+    try:
+        sock = socket.socket(socket.AF_INET6, socket.SOCK_DGRAM)
+        sock.bind(("::1", 0))
+        sock.close()
+        return True
+    except OSError:
+        return False
+
+def read_report(path):
+    """Return {header: [(count, error, key), ...]} and check line format and order."""
+    with open(path) as f:
+        text = f.read()
+    sections = {}
+    for block in text.strip("\n").split("\n\n"):
+        lines = block.split("\n")
+        assert lines[0] in HEADERS
+        entries = []
+        for line in lines[1:]:
+            match = LINE.match(line)
+            assert match, line
+            entries.append((int(match.group(1)), int(match.group(2)), match.group(3)))
+        counts = [count for count, _, _ in entries]
+        assert counts == sorted(counts, reverse=True)
+        sections[lines[0]] = entries
+    assert list(sections) == HEADERS
+    return sections
+
+def test_topk_report():
+    report_path = tempfile.mktemp(suffix=".topk")
+    proc, filter_file = start_dns_proxy(report_path)
+    try:
+        send_queries(socket.AF_INET, "127.0.0.1",
+                     ["ads.example.com"] * 5 + ["Other.example.org"] * 3 + ["rare.example.net"])
+
+        # Periodic dump gets snapshots from idle workers
+        time.sleep(DUMP_INTERVAL + 1)
+        queried, blocked, clients = read_report(report_path).values()
+        assert queried == [(5, 0, "ads.example.com"), (3, 0, "Other.example.org"), (1, 0, "rare.example.net")]
+        assert blocked == [(5, 0, "ads.example.com")]
+        assert clients == [(9, 0, "127.0.0.1")]
+    finally:
+        proc.send_signal(signal.SIGINT)
+        proc.wait(timeout=3)
+        os.unlink(filter_file)
+
+    # Final dump on exit
+    queried, _, _ = read_report(report_path).values()
+    assert queried[0] == (5, 0, "ads.example.com")
+    os.unlink(report_path)
+
+@pytest.mark.skipif(not ipv6_available(), reason="IPv6 loopback not available")
+def test_topk_merge_bounds():
+    report_path = tempfile.mktemp(suffix=".topk")
+    proc, filter_file = start_dns_proxy(report_path)
+    try:
+        # Same name on both workers is summed
+        send_queries(socket.AF_INET, "127.0.0.1", ["ads.example.com"] * 4)
+        send_queries(socket.AF_INET6, "::1", ["ads.example.com"] * 3)
+        # Fill IPv4 tracker so a name it does not hold may have been evicted there
+        send_queries(socket.AF_INET, "127.0.0.1", [f"n{i}.example.com" for i in range(300)])
+        send_queries(socket.AF_INET6, "::1", ["hot.example.com"] * 2)
+    finally:
+        proc.send_signal(signal.SIGINT)
+        proc.wait(timeout=3)
+        os.unlink(filter_file)
+
+    queried, blocked, clients = read_report(report_path).values()
+    os.unlink(report_path)
+
+    assert blocked == [(7, 0, "ads.example.com")]
+    assert queried[0] == (7, 0, "ads.example.com")
+    hot = [entry for entry in queried if entry[2] == "hot.example.com"]
+    # Real count 2 lies within reported bounds, IPv4 minimum widens both
+    assert hot and hot[0][0] - hot[0][1] <= 2 <= hot[0][0] and hot[0][1] > 0
+    assert sorted(key for _, _, key in clients) == ["127.0.0.1", "::1"]
+
+def test_topk_escapes_names():
+    report_path = tempfile.mktemp(suffix=".topk")
+    proc, filter_file = start_dns_proxy(report_path)
+    try:
+        # Label with newline could otherwise forge a report line
+        label = b"x\n     99999  (+0)  evil\\ \x7f"
+        forged = bytes([len(label)]) + label + b"\x03com\x00"
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.settimeout(1)
+        sock.sendto(struct.pack(">HHHHHH", 1, 0x0100, 1, 0, 0, 0) + forged + struct.pack(">HH", 15, 1),
+                    ("127.0.0.1", PORT))
+        sock.recv(512)
+        sock.close()
+    finally:
+        proc.send_signal(signal.SIGINT)
+        proc.wait(timeout=3)
+        os.unlink(filter_file)
+
+    queried, _, _ = read_report(report_path).values()
+    os.unlink(report_path)
+    assert queried == [(1, 0, "x\\x0a\\x20\\x20\\x20\\x20\\x2099999\\x20\\x20(+0)\\x20\\x20evil\\x5c\\x20\\x7f.com")]
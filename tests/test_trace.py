@@ -0,0 +1,82 @@
+import json
+import os
+import signal
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+from collections import defaultdict
+
+from conftest import TARGET, FakeUpstream
+
+PORT = 5327
+
+def send_query(sock, qname, qtype):
+    sock.sendto(struct.pack(">HHHHHH", 0x7777, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", qtype, 1),
+                ("127.0.0.1", PORT))
+    sock.recv(512)
+
+def test_trace_spans():
+    # Relayed query is traced only when fake upstream can be bound
+    try:
+        upstream = FakeUpstream()
+    except OSError:
+        upstream = None
+    trace_path = tempfile.mktemp(suffix=".json")
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", f.name, "-r", trace_path, "-n", "1"],
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    time.sleep(0.3)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1)
+    try:
+        send_query(sock, b"\x03ads\x07example\x03com\x00", 1)
+        # Quote, backslash and control byte in qname must be escaped in JSON
+        send_query(sock, b"\x07we\"i\\r\x01\x03com\x00", 15)
+        if upstream:
+            send_query(sock, b"\x05relay\x07example\x03org\x00", 1)
+    finally:
+        sock.close()
+        proc.send_signal(signal.SIGINT)
+        proc.wait(timeout=5)
+        if upstream:
+            upstream.close()
+        os.unlink(f.name)
+
+    with open(trace_path) as trace:
+        events = json.load(trace)["traceEvents"]
+    os.unlink(trace_path)
+
+    # Every async begin has one end of same span, not before it
+    spans = defaultdict(list)
+    for event in events:
+        if event["ph"] in "be":
+            spans[(event["id"], event["name"])].append(event)
+    for (span_id, name), pair in spans.items():
+        assert [e["ph"] for e in pair] == ["b", "e"], (span_id, name)
+        assert pair[0]["ts"] <= pair[1]["ts"]
+
+    queries = {pair[0]["args"]["qname"]: (span_id, pair[0]) for (span_id, name), pair in spans.items() if name == "query"}
+    assert queries["ads.example.com"][1]["args"]["verdict"] == "blocked"
+    assert queries["ads.example.com"][1]["args"]["rcode"] == "RCODE_REFUSED"
+    assert queries["we\"i\\r\x01.com"][1]["args"]["verdict"] == "not_implemented"
+
+    worker_spans = {e["name"] for e in events if e["ph"] == "X"}
+    assert {"wakeup", "recvfrom", "analyze_query", "respond"} <= worker_spans
+    assert all(e["dur"] >= 0 for e in events if e["ph"] == "X")
+
+    if upstream:
+        span_id, begin = queries["relay.example.org"]
+        assert begin["args"]["upstream"] and begin["args"]["rcode"] == "RCODE_NO_ERROR"
+        # Upstream wait nests inside whole query span
+        wait = spans[(span_id, "upstream")]
+        query = spans[(span_id, "query")]
+        assert query[0]["ts"] <= wait[0]["ts"] <= wait[1]["ts"] <= query[1]["ts"]
+        assert "relay_submit" in worker_spans and "sendto" in worker_spans
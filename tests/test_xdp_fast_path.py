@@ -0,0 +1,94 @@
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+import time
+
+import pytest
+
+from conftest import TARGET
+
+NETNS = "dnsxdp"
+HOST_IF = "veth-dns"
+PEER_IF = "veth-cli"
+HOST_IP = "10.200.0.1"
+PEER_IP = "10.200.0.2"
+PORT = 5310
+
+pytestmark = pytest.mark.skipif(
+    os.geteuid() != 0 or not shutil.which("clang") or not shutil.which("ip"),
+    reason="XDP test needs root, clang and iproute2",
+)
+
+# Sends one query from inside namespace and prints RCODE
+CLIENT = """
+import socket, struct, sys
+name, qtype = sys.argv[1], int(sys.argv[2])
+qname = b"".join(bytes([len(l)]) + l.encode() for l in name.split(".")) + b"\\0"
+pkt = struct.pack(">HHHHHH", 0x4242, 0x0100, 1, 0, 0, 0) + qname + struct.pack(">HH", qtype, 1)
+s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+s.settimeout(1)
+s.sendto(pkt, (sys.argv[3], int(sys.argv[4])))
+print(s.recv(512)[3] & 0x0F)
+"""
+
+def sh(*cmd):
+    subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+def query(name, qtype=1):
+    out = subprocess.run(
+        ["ip", "netns", "exec", NETNS, "python3", "-c", CLIENT, name, str(qtype), HOST_IP, str(PORT)],
+        stdout=subprocess.PIPE, text=True, timeout=3,
+    )
+    return int(out.stdout.strip())
+
+@pytest.fixture
+def veth_pair():
+    subprocess.run(["ip", "netns", "del", NETNS], stderr=subprocess.DEVNULL)
+    sh("make", "xdp")
+    sh("ip", "netns", "add", NETNS)
+    sh("ip", "link", "add", HOST_IF, "type", "veth", "peer", "name", PEER_IF)
+    sh("ip", "link", "set", PEER_IF, "netns", NETNS)
+    sh("ip", "addr", "add", f"{HOST_IP}/24", "dev", HOST_IF)
+    sh("ip", "link", "set", HOST_IF, "up")
+    sh("ip", "netns", "exec", NETNS, "ip", "addr", "add", f"{PEER_IP}/24", "dev", PEER_IF)
+    sh("ip", "netns", "exec", NETNS, "ip", "link", "set", PEER_IF, "up")
+    sh("ip", "link", "set", "dev", HOST_IF, "xdpgeneric", "obj", "xdp_filter.o", "sec", "xdp")
+
+    pin_dir = next(d for d in ("/sys/fs/bpf/xdp/globals", "/sys/fs/bpf/tc/globals")
+                   if os.path.exists(os.path.join(d, "dns_blocklist")))
+    yield pin_dir
+
+    subprocess.run(["ip", "link", "set", "dev", HOST_IF, "xdpgeneric", "off"], stderr=subprocess.DEVNULL)
+    subprocess.run(["ip", "link", "del", HOST_IF], stderr=subprocess.DEVNULL)
+    subprocess.run(["ip", "netns", "del", NETNS], stderr=subprocess.DEVNULL)
+    for m in ("dns_blocklist", "dns_config"):
+        try:
+            os.unlink(os.path.join(pin_dir, m))
+        except OSError:
+            pass
+
+def test_blocked_answered_in_kernel(veth_pair):
+    f = tempfile.NamedTemporaryFile(mode="w", delete=False)
+    f.write("ads.example.com\n")
+    f.close()
+
+    proc = subprocess.Popen(
+        [TARGET, "-s", "127.0.0.1", "-p", str(PORT), "-f", f.name, "-x", veth_pair, "-v"],
+        stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True,
+    )
+    time.sleep(0.3)
+
+    assert query("ads.example.com") == 5       # REFUSED from XDP
+    assert query("Sub.Ads.Example.com") == 5   # Parent match, case insensitive
+    assert query("example.com", 28) == 4       # Passed up, NOTIMP from userspace
+
+    proc.terminate()
+    stdout, _ = proc.communicate(timeout=2)
+    os.unlink(f.name)
+
+    assert "XDP fast path: 1 rules loaded" in stdout
+    assert "Name: ads.example.com" not in stdout
+    assert "Name: Sub.Ads.Example.com" not in stdout
+    assert "Name: example.com" in stdout
@@ -0,0 +1,338 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+#include <cstring>
+
+#include <arpa/inet.h>
+
+#include "topk_helper.hpp"
+#include "worker_helper.hpp"
+
+constexpr size_t TOPK_INDEX_SIZE = TOPK_CAPACITY * 2; // Power of two, half full at most
+
+struct topk_entry {
+    uint64_t hash;
+    uint64_t count;
+    uint64_t error;      // Count inherited from evicted entry, upper bound of overestimation
+    uint16_t heap_pos;
+    uint8_t key_length;
+    uint8_t key[255];    // Name, or raw client address
+};
+
+// Space-Saving summary: fixed entries, min-heap by count, open addressing index by hash
+struct topk_tracker {
+    topk_entry entries[TOPK_CAPACITY];
+    uint16_t heap[TOPK_CAPACITY];
+    int16_t index[TOPK_INDEX_SIZE];
+    size_t size = 0;
+
+    topk_tracker() { std::fill(std::begin(index), std::end(index), -1); }
+};
+
+struct topk_trackers {
+    topk_tracker queried;
+    topk_tracker blocked;
+    topk_tracker clients;
+};
+
+// Live trackers are touched only by their worker. Dumper bumps `requested`, worker copies live
+// trackers to `snapshot` on its next query or poll and publishes the request number back.
+struct topk_worker {
+    topk_trackers live;
+    topk_trackers snapshot;
+    std::atomic<uint32_t> requested{0};
+    std::atomic<uint32_t> published{0};
+};
+
+static topk_worker workers[WORKER_SLOTS];
+static worker_registry worker_count{0};
+static thread_local topk_worker* local_worker = nullptr;
+
+// FNV-1a 64-bit, case insensitive so names differing in case count together
+static inline uint64_t hash_key(const uint8_t* key, size_t length) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t c = key[i];
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void heap_swap(topk_tracker& t, size_t a, size_t b) {
+    std::swap(t.heap[a], t.heap[b]);
+    t.entries[t.heap[a]].heap_pos = a;
+    t.entries[t.heap[b]].heap_pos = b;
+}
+
+static void sift_up(topk_tracker& t, size_t pos) {
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (t.entries[t.heap[parent]].count <= t.entries[t.heap[pos]].count) break;
+        heap_swap(t, pos, parent);
+        pos = parent;
+    }
+}
+
+static void sift_down(topk_tracker& t, size_t pos) {
+    while (true) {
+        size_t smallest = pos;
+        size_t left = 2 * pos + 1, right = left + 1;
+        if (left < t.size && t.entries[t.heap[left]].count < t.entries[t.heap[smallest]].count) smallest = left;
+        if (right < t.size && t.entries[t.heap[right]].count < t.entries[t.heap[smallest]].count) smallest = right;
+        if (smallest == pos) break;
+        heap_swap(t, pos, smallest);
+        pos = smallest;
+    }
+}
+
+static size_t index_slot(const topk_tracker& t, uint64_t hash) {
+    size_t slot = hash & (TOPK_INDEX_SIZE - 1);
+    while (t.index[slot] != -1 && t.entries[t.index[slot]].hash != hash) {
+        slot = (slot + 1) & (TOPK_INDEX_SIZE - 1);
+    }
+    return slot;
+}
+
+// Linear probing removal with backward shift, keeps probe chains intact without tombstones
+static void index_remove(topk_tracker& t, uint64_t hash) {
+    size_t hole = index_slot(t, hash);
+    t.index[hole] = -1;
+
+    size_t next = hole;
+    while (true) {
+        next = (next + 1) & (TOPK_INDEX_SIZE - 1);
+        if (t.index[next] == -1) return;
+
+        size_t home = t.entries[t.index[next]].hash & (TOPK_INDEX_SIZE - 1);
+        bool movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            t.index[hole] = t.index[next];
+            t.index[next] = -1;
+            hole = next;
+        }
+    }
+}
+
+static void update(topk_tracker& t, const uint8_t* key, size_t length) {
+    length = std::min<size_t>(length, sizeof(topk_entry::key));
+    uint64_t hash = hash_key(key, length);
+    size_t slot = index_slot(t, hash);
+
+    if (t.index[slot] != -1) {
+        topk_entry& entry = t.entries[t.index[slot]];
+        entry.count++;
+        sift_down(t, entry.heap_pos);
+        return;
+    }
+
+    size_t victim;
+    uint64_t base = 0;
+    if (t.size < TOPK_CAPACITY) {
+        victim = t.size;
+        t.heap[t.size] = victim;
+        t.entries[victim].heap_pos = t.size;
+        t.size++;
+    } else {
+        // Replace least counted entry, new one inherits its count as error
+        victim = t.heap[0];
+        base = t.entries[victim].count;
+        index_remove(t, t.entries[victim].hash);
+        slot = index_slot(t, hash);
+    }
+
+    topk_entry& entry = t.entries[victim];
+    entry.hash = hash;
+    entry.count = base + 1;
+    entry.error = base;
+    entry.key_length = length;
+    memcpy(entry.key, key, length);
+    t.index[slot] = victim;
+
+    if (base == 0) sift_up(t, entry.heap_pos);
+    else sift_down(t, entry.heap_pos);
+}
+
+void topk_attach() {
+    int index = worker_claim(worker_count, "top-K tracking");
+    if (index >= 0) local_worker = &workers[index];
+}
+
+void topk_poll() {
+    topk_worker* w = local_worker;
+    if (!w) return;
+
+    uint32_t requested = w->requested.load(std::memory_order_acquire);
+    if (requested == w->published.load(std::memory_order_relaxed)) return;
+
+    w->snapshot = w->live;
+    w->published.store(requested, std::memory_order_release);
+}
+
+void topk_record(const dns_packet& pkt, const dns_query& query) {
+    topk_worker* w = local_worker;
+    if (!w) return;
+
+    if (!query.qname.empty()) {
+        const uint8_t* name = reinterpret_cast<const uint8_t*>(query.qname.data());
+        update(w->live.queried, name, query.qname.size());
+        if (query.blocked) update(w->live.blocked, name, query.qname.size());
+    }
+
+    if (pkt.clientAddr.ss_family == AF_INET) {
+        const sockaddr_in* addr4 = reinterpret_cast<const sockaddr_in*>(&pkt.clientAddr);
+        update(w->live.clients, reinterpret_cast<const uint8_t*>(&addr4->sin_addr), 4);
+    } else if (pkt.clientAddr.ss_family == AF_INET6) {
+        const sockaddr_in6* addr6 = reinterpret_cast<const sockaddr_in6*>(&pkt.clientAddr);
+        update(w->live.clients, reinterpret_cast<const uint8_t*>(&addr6->sin6_addr), 16);
+    }
+
+    topk_poll();
+}
+
+// Names are raw label bytes from clients, escape everything outside printable ASCII, space and
+// backslash as \xNN so every report line stays "count  (+error)  key"
+static std::string escape_key(const uint8_t* key, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    std::string escaped;
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t c = key[i];
+        if (c <= 0x20 || c >= 0x7F || c == '\\') {
+            escaped += "\\x";
+            escaped += hex[c >> 4];
+            escaped += hex[c & 0x0F];
+        } else {
+            escaped += static_cast<char>(c);
+        }
+    }
+    return escaped;
+}
+
+struct topk_merged {
+    uint64_t count = 0;
+    uint64_t error = 0;
+    uint64_t held_min = 0; // Sum of minimum counts of full trackers holding the key
+    const topk_entry* entry = nullptr;
+};
+
+// Minimum count of full tracker, any key it does not hold was seen at most this many times
+static uint64_t tracker_min(const topk_tracker& t) {
+    return t.size < TOPK_CAPACITY ? 0 : t.entries[t.heap[0]].count;
+}
+
+// Sum counters of same key over workers. Tracker not holding the key adds its minimum count
+// to both count and error, so counts are upper bounds and count - error lower bounds.
+static void write_section(std::ofstream& out, const char* title, const std::vector<const topk_tracker*>& trackers, bool clients) {
+    std::unordered_map<uint64_t, topk_merged> merged;
+    uint64_t total_min = 0;
+    for (const topk_tracker* t : trackers) {
+        uint64_t min = tracker_min(*t);
+        total_min += min;
+        for (size_t i = 0; i < t->size; ++i) {
+            topk_merged& m = merged[t->entries[i].hash];
+            m.count += t->entries[i].count;
+            m.error += t->entries[i].error;
+            m.held_min += min;
+            m.entry = &t->entries[i];
+        }
+    }
+
+    std::vector<topk_merged> sorted;
+    sorted.reserve(merged.size());
+    for (const auto& kv : merged) {
+        topk_merged m = kv.second;
+        m.count += total_min - m.held_min;
+        m.error += total_min - m.held_min;
+        sorted.push_back(m);
+    }
+    size_t n = std::min(TOPK_REPORT, sorted.size());
+    std::partial_sort(sorted.begin(), sorted.begin() + n, sorted.end(),
+                      [](const topk_merged& a, const topk_merged& b) { return a.count > b.count; });
+
+    out << "# " << title << " (count, max overestimation)\n";
+    for (size_t i = 0; i < n; ++i) {
+        const topk_entry& e = *sorted[i].entry;
+        std::string key;
+        if (clients) {
+            char ip[INET6_ADDRSTRLEN];
+            inet_ntop(e.key_length == 4 ? AF_INET : AF_INET6, e.key, ip, sizeof(ip));
+            key = ip;
+        } else {
+            key = escape_key(e.key, e.key_length);
+        }
+        out << std::right << std::setw(10) << sorted[i].count << "  (+" << sorted[i].error << ")  " << key << "\n";
+    }
+    out << "\n";
+}
+
+static void write_report(const std::string& path, const std::vector<const topk_trackers*>& sources) {
+    std::vector<const topk_tracker*> queried, blocked, clients;
+    for (const topk_trackers* t : sources) {
+        queried.push_back(&t->queried);
+        blocked.push_back(&t->blocked);
+        clients.push_back(&t->clients);
+    }
+
+    std::string tmp = path + ".tmp";
+    std::ofstream out(tmp, std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "ERROR: Cannot open file '" << tmp << "'\n";
+        return;
+    }
+
+    write_section(out, "Top queried names", queried, false);
+    write_section(out, "Top blocked names", blocked, false);
+    write_section(out, "Top clients", clients, true);
+    out.close();
+
+    if (rename(tmp.c_str(), path.c_str()) < 0) {
+        perror("ERROR: rename (top-K report)");
+    }
+}
+
+void topk_dump(const std::string& path) {
+    std::vector<const topk_trackers*> sources;
+    int count = worker_claimed(worker_count);
+    for (int i = 0; i < count; ++i) sources.push_back(&workers[i].live);
+    write_report(path, sources);
+}
+
+// Request snapshot from every worker, workers publish it within one select() timeout
+static void dump_snapshots(volatile sig_atomic_t& running, const std::string& path) {
+    int count = worker_claimed(worker_count);
+    uint32_t requested[WORKER_SLOTS];
+    for (int i = 0; i < count; ++i) {
+        requested[i] = workers[i].requested.fetch_add(1, std::memory_order_release) + 1;
+    }
+
+    std::vector<const topk_trackers*> sources;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (int i = 0; i < count; ++i) {
+        while (running && workers[i].published.load(std::memory_order_acquire) != requested[i] &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        // Worker that did not answer in time is left out of this report
+        if (workers[i].published.load(std::memory_order_acquire) == requested[i]) {
+            sources.push_back(&workers[i].snapshot);
+        }
+    }
+    if (running) write_report(path, sources);
+}
+
+void topk_dumper(volatile sig_atomic_t& running, const std::string& path) {
+    periodic_dumper(running, TOPK_DUMP_INTERVAL, [&] { dump_snapshots(running, path); });
+}
@@ -0,0 +1,34 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <csignal>
+#include <string>
+
+#include "dns_structures.hpp"
+
+constexpr size_t TOPK_CAPACITY = 256;     // Space-Saving counters per tracker and worker
+constexpr size_t TOPK_REPORT = 20;        // Entries printed per tracker
+constexpr int TOPK_DUMP_INTERVAL = 10;    // Seconds between dumps
+
+// Called by each worker thread before recording, binds it to its own trackers
+void topk_attach();
+
+// Count query name, blocked name and client of answered query
+void topk_record(const dns_packet& pkt, const dns_query& query);
+
+// Publish snapshot of worker trackers if dumper asked for one, called on every worker loop
+void topk_poll();
+
+// Merge live trackers of all workers and write report to path (atomically replaced),
+// only after workers have stopped
+void topk_dump(const std::string& path);
+
+// Dumper thread body, writes report from worker snapshots every TOPK_DUMP_INTERVAL seconds until `running` is cleared
+void topk_dumper(volatile sig_atomic_t& running, const std::string& path);
@@ -0,0 +1,250 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "rcode.hpp"
+#include "trace_helper.hpp"
+#include "worker_helper.hpp"
+
+struct trace_event {
+    const char* name;      // Static string
+    uint64_t start;        // ns, steady clock
+    uint64_t end;
+    uint64_t query;        // trace_start of query, groups async spans
+    bool async;
+    // Arguments, set only on whole query span
+    const char* upstream;
+    uint16_t qtype;
+    uint8_t verdict;
+    uint8_t rcode;
+    uint32_t rtt_us;
+    uint8_t qname_length;
+    char qname[255];
+};
+
+// Ring of most recent spans, written by owning worker only
+struct trace_worker {
+    std::mutex lock; // Uncontended except while dump copies events
+    std::vector<trace_event> events;
+    size_t next = 0;
+    bool wrapped = false;
+    uint32_t sample_every = 1;
+    uint32_t countdown = 1;
+};
+
+static trace_worker workers[WORKER_SLOTS];
+static worker_registry worker_count{0};
+static thread_local trace_worker* local_worker = nullptr;
+
+static inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static trace_event& push_event(trace_worker* w, const char* name, uint64_t query, uint64_t start, bool async) {
+    trace_event& event = w->events[w->next];
+    event.name = name;
+    event.start = start;
+    event.end = now_ns();
+    event.query = query;
+    event.async = async;
+    event.upstream = nullptr;
+    event.qname_length = 0;
+
+    if (++w->next == w->events.size()) {
+        w->next = 0;
+        w->wrapped = true;
+    }
+    return event;
+}
+
+void trace_attach(uint32_t sample_every) {
+    int index = worker_claim(worker_count, "tracing");
+    if (index < 0) return;
+
+    trace_worker* w = &workers[index];
+    std::lock_guard<std::mutex> guard(w->lock);
+    w->events.resize(TRACE_BUFFER_EVENTS);
+    w->sample_every = sample_every ? sample_every : 1;
+    w->countdown = w->sample_every;
+    local_worker = w;
+}
+
+uint64_t trace_mark(uint64_t query_start) {
+    return query_start ? now_ns() : 0;
+}
+
+uint64_t trace_sample() {
+    trace_worker* w = local_worker;
+    if (!w || --w->countdown) return 0;
+
+    w->countdown = w->sample_every;
+    return now_ns();
+}
+
+void trace_span(uint64_t query_start, const char* name, uint64_t start) {
+    trace_worker* w = local_worker;
+    if (!w || !query_start) return;
+
+    std::lock_guard<std::mutex> guard(w->lock);
+    push_event(w, name, query_start, start, false);
+}
+
+void trace_wakeup(uint64_t query_start, uint64_t received_ns) {
+    trace_worker* w = local_worker;
+    if (!w || !query_start || !received_ns) return;
+
+    // Kernel stamps with realtime clock, shift it onto steady clock of other spans
+    uint64_t realtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (received_ns > realtime) return;
+    uint64_t start = now_ns() - (realtime - received_ns);
+    if (start > query_start || query_start - start > TRACE_WAKEUP_MAX_NS) return;
+
+    std::lock_guard<std::mutex> guard(w->lock);
+    trace_event& event = push_event(w, "wakeup", query_start, start, false);
+    event.end = query_start;
+}
+
+void trace_async(uint64_t query_start, const char* name, uint64_t start) {
+    trace_worker* w = local_worker;
+    if (!w || !query_start) return;
+
+    std::lock_guard<std::mutex> guard(w->lock);
+    push_event(w, name, query_start, start, true);
+}
+
+void trace_query(const dns_query& query, QUERY_VERDICT verdict, const char* upstream) {
+    trace_worker* w = local_worker;
+    if (!w || !query.trace_start) return;
+
+    std::lock_guard<std::mutex> guard(w->lock);
+    trace_event& event = push_event(w, "query", query.trace_start, query.trace_start, true);
+    event.upstream = upstream;
+    event.qtype = query.qtype;
+    event.verdict = verdict;
+    event.rcode = query.rcode;
+    event.rtt_us = query.upstream_rtt_us;
+    event.qname_length = std::min<size_t>(query.qname.size(), sizeof(event.qname));
+    memcpy(event.qname, query.qname.data(), event.qname_length);
+}
+
+static const char* verdict_to_string(uint8_t verdict) {
+    switch (verdict) {
+        case VERDICT_ALLOWED:         return "allowed";
+        case VERDICT_BLOCKED:         return "blocked";
+        case VERDICT_NOT_IMPLEMENTED: return "not_implemented";
+        case VERDICT_MALFORMED:       return "malformed";
+        case VERDICT_LOCAL:           return "local";
+        case VERDICT_SHED:            return "shed";
+        default:                      return "unknown";
+    }
+}
+
+// Names are raw label bytes, escape everything outside printable ASCII
+static void write_json_string(std::ofstream& out, const char* data, size_t length) {
+    out << '"';
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t c = static_cast<uint8_t>(data[i]);
+        if (c == '"' || c == '\\') {
+            out << '\\' << static_cast<char>(c);
+        } else if (c < 0x20 || c >= 0x7F) {
+            out << "\\u00" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c)
+                << std::dec << std::setfill(' ');
+        } else {
+            out << static_cast<char>(c);
+        }
+    }
+    out << '"';
+}
+
+// Chrome trace timestamps are microseconds
+static void write_us(std::ofstream& out, uint64_t ns) {
+    out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+}
+
+static void write_event(std::ofstream& out, const trace_event& event, int pid, int tid) {
+    if (!event.async) {
+        out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"worker\",\"ph\":\"X\",\"pid\":" << pid
+            << ",\"tid\":" << tid << ",\"ts\":";
+        write_us(out, event.start);
+        out << ",\"dur\":";
+        write_us(out, event.end - event.start);
+        out << "}";
+        return;
+    }
+
+    // Async begin/end pair, spans of same query share id and nest on one track
+    for (int phase = 0; phase < 2; ++phase) {
+        out << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"query\",\"ph\":\"" << (phase ? 'e' : 'b')
+            << "\",\"id\":\"" << tid << "-" << event.query << "\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":";
+        write_us(out, phase ? event.end : event.start);
+
+        if (phase == 0 && event.qname_length) {
+            out << ",\"args\":{\"qname\":";
+            write_json_string(out, event.qname, event.qname_length);
+            out << ",\"qtype\":" << event.qtype
+                << ",\"verdict\":\"" << verdict_to_string(event.verdict) << "\""
+                << ",\"rcode\":\"" << RCODE_to_string(static_cast<RCODE>(event.rcode)) << "\"";
+            if (event.upstream) {
+                out << ",\"upstream\":";
+                write_json_string(out, event.upstream, strlen(event.upstream));
+                out << ",\"upstream_rtt_us\":" << event.rtt_us;
+            }
+            out << "}";
+        }
+        out << "}";
+    }
+}
+
+void trace_dump(const std::string& path) {
+    int count = worker_claimed(worker_count);
+    std::vector<std::vector<trace_event>> copies(count);
+
+    // Copy under lock in order from oldest, write without holding workers
+    for (int i = 0; i < count; ++i) {
+        std::lock_guard<std::mutex> guard(workers[i].lock);
+        const trace_worker& w = workers[i];
+        if (w.wrapped) copies[i].assign(w.events.begin() + w.next, w.events.end());
+        copies[i].insert(copies[i].end(), w.events.begin(), w.events.begin() + w.next);
+    }
+
+    std::string tmp = path + ".tmp";
+    std::ofstream out(tmp, std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "ERROR: Cannot open file '" << tmp << "'\n";
+        return;
+    }
+
+    int pid = getpid();
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"args\":{\"name\":\"dns\"}}";
+    for (int i = 0; i < count; ++i) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << i
+            << ",\"args\":{\"name\":\"worker " << i << "\"}}";
+        for (const auto& event : copies[i]) write_event(out, event, pid, i);
+    }
+    out << "\n]}\n";
+    out.close();
+
+    if (rename(tmp.c_str(), path.c_str()) < 0) {
+        perror("ERROR: rename (trace)");
+    }
+}
+
+void trace_dumper(volatile sig_atomic_t& running, const std::string& path) {
+    periodic_dumper(running, TRACE_DUMP_INTERVAL, [&] { trace_dump(path); });
+}
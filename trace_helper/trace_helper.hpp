@@ -0,0 +1,46 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <csignal>
+#include <string>
+
+#include "dns_structures.hpp"
+#include "log_helper.hpp"
+
+constexpr size_t TRACE_BUFFER_EVENTS = 8192;           // Most recent spans kept per worker
+constexpr int TRACE_DUMP_INTERVAL = 10;                // Seconds between dumps
+constexpr uint64_t TRACE_WAKEUP_MAX_NS = 1000000000;   // Longer wakeup means realtime clock was stepped, span skipped
+
+// Called by each worker thread before tracing, traces one of every sample_every queries
+void trace_attach(uint32_t sample_every);
+
+// Monotonic time in ns if query is traced (query_start != 0), 0 otherwise
+uint64_t trace_mark(uint64_t query_start);
+
+// Start time of query received now if it is sampled, 0 otherwise
+uint64_t trace_sample();
+
+// Step of traced query on worker thread from start to now
+void trace_span(uint64_t query_start, const char* name, uint64_t start);
+
+// Kernel receive (CLOCK_REALTIME ns, 0 if unknown) to query_start, covers socket queue and select() wakeup
+void trace_wakeup(uint64_t query_start, uint64_t received_ns);
+
+// Step of traced query that overlaps other queries (upstream wait), shown on query track
+void trace_async(uint64_t query_start, const char* name, uint64_t start);
+
+// Whole traced query from query.trace_start to now, tagged with qname, verdict and upstream
+void trace_query(const dns_query& query, QUERY_VERDICT verdict, const char* upstream);
+
+// Write spans of all workers to path as Chrome trace event JSON (atomically replaced)
+void trace_dump(const std::string& path);
+
+// Dumper thread body, writes trace every TRACE_DUMP_INTERVAL seconds until `running` is cleared
+void trace_dumper(volatile sig_atomic_t& running, const std::string& path);
@@ -0,0 +1,38 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+#include "worker_helper.hpp"
+
+int worker_claim(worker_registry& registry, const char* feature) {
+    int index = registry.fetch_add(1);
+    if (index >= WORKER_SLOTS) {
+        std::cerr << "WARNING: too many workers for " << feature << ", worker not included\n";
+        return -1;
+    }
+    return index;
+}
+
+int worker_claimed(const worker_registry& registry) {
+    return std::min(registry.load(), WORKER_SLOTS);
+}
+
+void periodic_dumper(volatile sig_atomic_t& running, int interval, const std::function<void()>& dump) {
+    auto last_dump = std::chrono::steady_clock::now();
+
+    // Short sleeps so stop is noticed within 250ms
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        if (std::chrono::steady_clock::now() - last_dump >= std::chrono::seconds(interval)) {
+            dump();
+            last_dump = std::chrono::steady_clock::now();
+        }
+    }
+}
@@ -0,0 +1,25 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <atomic>
+#include <csignal>
+#include <functional>
+
+constexpr int WORKER_SLOTS = 8; // Per-worker state slots of log, top-K and trace helpers
+
+// Counter of slots claimed by worker threads, slot storage stays in the helper owning it
+using worker_registry = std::atomic<int>;
+
+// Claim next free slot for calling worker, -1 with warning naming `feature` when all are taken
+int worker_claim(worker_registry& registry, const char* feature);
+
+// Number of slots claimed so far, valid indexes are 0 .. count - 1
+int worker_claimed(const worker_registry& registry);
+
+// Dumper thread body, calls dump every interval seconds until `running` is cleared
+void periodic_dumper(volatile sig_atomic_t& running, int interval, const std::function<void()>& dump);
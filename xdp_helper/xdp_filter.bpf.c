@@ -0,0 +1,193 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ *
+ * XDP fast path answering queries for blocked domains with REFUSED in kernel.
+ * Build: make xdp, load: ip link set dev <iface> xdpgeneric obj xdp_filter.o sec xdp
+ * Maps are pinned by name and filled by the proxy started with -x <pin dir>.
+ */
+
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/ipv6.h>
+#include <linux/in.h>
+#include <linux/udp.h>
+
+// Minimal subset of libbpf bpf_helpers.h, so only kernel headers are needed
+#define SEC(name) __attribute__((section(name), used))
+#undef __always_inline
+#define __always_inline inline __attribute__((always_inline))
+#define __uint(name, val) int (*name)[val]
+#define __type(name, val) typeof(val) *name
+#define PIN_BY_NAME 1
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define bpf_htons(x) __builtin_bswap16(x)
+#else
+#define bpf_htons(x) (x)
+#endif
+
+static void *(*bpf_map_lookup_elem)(void *map, const void *key) = (void *) BPF_FUNC_map_lookup_elem;
+
+#define DNS_HEADER_LENGTH 12
+#define MAX_QNAME 255
+#define RCODE_REFUSED 5
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// Key is FNV-1a of blocked domain hashed from last to first character (see xdp_helper.cpp)
+struct {
+    __uint(type, BPF_MAP_TYPE_HASH);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
+    __uint(max_entries, 1 << 21);
+    __type(key, __u64);
+    __type(value, __u8);
+    __uint(pinning, PIN_BY_NAME);
+} dns_blocklist SEC(".maps");
+
+struct xdp_config {
+    __u16 port;    // Proxy listening port, host byte order
+    __u16 enabled; // Set by proxy once blocklist is filled
+};
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, 1);
+    __type(key, __u32);
+    __type(value, struct xdp_config);
+    __uint(pinning, PIN_BY_NAME);
+} dns_config SEC(".maps");
+
+static __always_inline __u16 csum_replace(__u16 check, __u16 old, __u16 new) {
+    __u32 sum = (__u16)~check + (__u16)~old + new;
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum;
+}
+
+// Lowercase dotted QNAME into name, returns length or -1 when query is not handled here
+static __always_inline int parse_qname(__u8 *p, void *data_end, __u8 *name) {
+    int len = 0;
+    __u32 label_left = 0;
+
+    for (int i = 0; i < MAX_QNAME; i++) {
+        if ((void *)(p + 1) > data_end) return -1;
+        __u8 c = *p++;
+
+        if (label_left == 0) {
+            if (c == 0) {
+                // QTYPE + QCLASS must follow, otherwise FORMERR path in userspace
+                if ((void *)(p + 4) > data_end) return -1;
+                return len;
+            }
+            if (c & 0xC0) return -1; // Compression in query
+            label_left = c;
+            if (len > 0) name[len++ & MAX_QNAME] = '.';
+            continue;
+        }
+
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        name[len++ & MAX_QNAME] = c;
+        label_left--;
+    }
+    return -1;
+}
+
+// Exact or parent domain match, same as is_blocked() in userspace
+static __always_inline int is_blocked(__u8 *name, int len) {
+    __u64 hash = FNV_OFFSET;
+
+    for (int i = MAX_QNAME - 1; i >= 0; i--) {
+        if (i >= len) continue;
+        hash ^= name[i];
+        hash *= FNV_PRIME;
+        if (i == 0 || name[(i - 1) & MAX_QNAME] == '.') {
+            if (bpf_map_lookup_elem(&dns_blocklist, &hash)) return 1;
+        }
+    }
+    return 0;
+}
+
+SEC("xdp")
+int xdp_dns_filter(struct xdp_md *ctx) {
+    void *data = (void *)(long)ctx->data;
+    void *data_end = (void *)(long)ctx->data_end;
+
+    __u32 key = 0;
+    struct xdp_config *cfg = bpf_map_lookup_elem(&dns_config, &key);
+    if (!cfg || !cfg->enabled) return XDP_PASS;
+
+    struct ethhdr *eth = data;
+    if ((void *)(eth + 1) > data_end) return XDP_PASS;
+
+    struct iphdr *ip4 = 0;
+    struct ipv6hdr *ip6 = 0;
+    struct udphdr *udp;
+
+    if (eth->h_proto == bpf_htons(ETH_P_IP)) {
+        ip4 = (void *)(eth + 1);
+        if ((void *)(ip4 + 1) > data_end) return XDP_PASS;
+        if (ip4->ihl != 5 || ip4->protocol != IPPROTO_UDP) return XDP_PASS;
+        if (ip4->frag_off & bpf_htons(0x3FFF)) return XDP_PASS; // MF or offset
+        udp = (void *)(ip4 + 1);
+    } else if (eth->h_proto == bpf_htons(ETH_P_IPV6)) {
+        ip6 = (void *)(eth + 1);
+        if ((void *)(ip6 + 1) > data_end) return XDP_PASS;
+        if (ip6->nexthdr != IPPROTO_UDP) return XDP_PASS;
+        udp = (void *)(ip6 + 1);
+    } else {
+        return XDP_PASS;
+    }
+
+    if ((void *)(udp + 1) > data_end) return XDP_PASS;
+    if (udp->dest != bpf_htons(cfg->port)) return XDP_PASS;
+
+    __u8 *dns = (void *)(udp + 1);
+    if ((void *)(dns + DNS_HEADER_LENGTH) > data_end) return XDP_PASS;
+    if (dns[2] & 0x80) return XDP_PASS;                // Not a query
+    if (dns[4] != 0 || dns[5] != 1) return XDP_PASS;   // QDCOUNT != 1
+
+    __u8 name[MAX_QNAME + 1] = {};
+    int len = parse_qname(dns + DNS_HEADER_LENGTH, data_end, name);
+    if (len <= 0 || !is_blocked(name, len)) return XDP_PASS;
+
+    // Same answer as send_response(): echo query, QR = 1, keep RD, RCODE REFUSED, no records
+    __u16 *words = (__u16 *)dns;
+    __u16 old[6], check = udp->check;
+    for (int i = 1; i < 6; i++) old[i] = words[i];
+
+    dns[2] = (dns[2] | 0x80) & 0x81;
+    dns[3] = (dns[3] & 0xF0) | RCODE_REFUSED;
+    dns[6] = dns[7] = dns[8] = dns[9] = dns[10] = dns[11] = 0;
+
+    if (check || ip6) {
+        for (int i = 1; i < 6; i++) check = csum_replace(check, old[i], words[i]);
+        udp->check = check ? check : 0xFFFF;
+    }
+
+    // Bounce back: swap ports, addresses and MACs, checksums are unaffected by swaps
+    __u16 port = udp->source;
+    udp->source = udp->dest;
+    udp->dest = port;
+
+    if (ip4) {
+        __u32 addr = ip4->saddr;
+        ip4->saddr = ip4->daddr;
+        ip4->daddr = addr;
+    } else {
+        struct in6_addr addr = ip6->saddr;
+        ip6->saddr = ip6->daddr;
+        ip6->daddr = addr;
+    }
+
+    __u8 mac[ETH_ALEN];
+    __builtin_memcpy(mac, eth->h_source, ETH_ALEN);
+    __builtin_memcpy(eth->h_source, eth->h_dest, ETH_ALEN);
+    __builtin_memcpy(eth->h_dest, mac, ETH_ALEN);
+
+    return XDP_TX;
+}
+
+char _license[] SEC("license") = "GPL";
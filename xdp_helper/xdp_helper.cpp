@@ -0,0 +1,130 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <iostream>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+
+#include "xdp_helper.hpp"
+
+// Must match struct xdp_config in xdp_filter.bpf.c
+struct xdp_config {
+    uint16_t port;
+    uint16_t enabled;
+};
+
+// Raw bpf(2) wrappers, pinned maps need no libbpf
+static int bpf_call(int cmd, union bpf_attr& attr) {
+    return syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+}
+
+static int bpf_obj_get(const std::string& path) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.pathname = reinterpret_cast<uint64_t>(path.c_str());
+    return bpf_call(BPF_OBJ_GET, attr);
+}
+
+static int bpf_map_update(int fd, const void* key, const void* value) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = fd;
+    attr.key = reinterpret_cast<uint64_t>(key);
+    attr.value = reinterpret_cast<uint64_t>(value);
+    attr.flags = BPF_ANY;
+    return bpf_call(BPF_MAP_UPDATE_ELEM, attr);
+}
+
+static int bpf_map_first_key(int fd, void* key) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = fd;
+    attr.key = 0; // NULL returns first key
+    attr.next_key = reinterpret_cast<uint64_t>(key);
+    return bpf_call(BPF_MAP_GET_NEXT_KEY, attr);
+}
+
+static int bpf_map_delete(int fd, const void* key) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = fd;
+    attr.key = reinterpret_cast<uint64_t>(key);
+    return bpf_call(BPF_MAP_DELETE_ELEM, attr);
+}
+
+static bool write_config(const std::string& pin_dir, uint16_t port, bool enabled) {
+    int fd = bpf_obj_get(pin_dir + "/dns_config");
+    if (fd < 0) {
+        perror("ERROR: bpf obj get (dns_config)");
+        return false;
+    }
+
+    uint32_t key = 0;
+    xdp_config cfg{port, static_cast<uint16_t>(enabled)};
+    bool ok = bpf_map_update(fd, &key, &cfg) == 0;
+    if (!ok) perror("ERROR: bpf map update (dns_config)");
+    close(fd);
+    return ok;
+}
+
+uint64_t xdp_domain_hash(std::string_view domain) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = domain.size(); i-- > 0;) {
+        hash ^= static_cast<uint8_t>(domain[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool xdp_load_filters(const std::string& pin_dir, const filter_set& rules,
+                      uint16_t port, bool verbose) {
+    // Keep kernel passing queries up while map is rebuilt
+    if (!write_config(pin_dir, port, false))
+        return false;
+
+    int fd = bpf_obj_get(pin_dir + "/dns_blocklist");
+    if (fd < 0) {
+        perror("ERROR: bpf obj get (dns_blocklist)");
+        return false;
+    }
+
+    // Drop rules left by previous run
+    uint64_t key;
+    while (bpf_map_first_key(fd, &key) == 0) {
+        if (bpf_map_delete(fd, &key) < 0) break;
+    }
+
+    const uint8_t value = 1;
+    size_t loaded = 0;
+    bool failed = false;
+    for_each_rule(rules, [&](std::string_view rule) {
+        if (failed) return;
+        key = xdp_domain_hash(rule);
+        if (bpf_map_update(fd, &key, &value) < 0) {
+            perror("ERROR: bpf map update (dns_blocklist)");
+            failed = true;
+            return;
+        }
+        loaded++;
+    });
+    close(fd);
+
+    if (failed || !write_config(pin_dir, port, true))
+        return false;
+
+    if (verbose) {
+        std::cout << "XDP fast path: " << loaded << " rules loaded into " << pin_dir << "\n";
+        std::cout << "==========================================\n";
+    }
+    return true;
+}
+
+void xdp_disable(const std::string& pin_dir) {
+    write_config(pin_dir, 0, false);
+}
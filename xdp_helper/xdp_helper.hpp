@@ -0,0 +1,24 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "filter_helper.hpp"
+
+// Hash shared with xdp_filter.bpf.c: FNV-1a over domain from last to first character,
+// so kernel gets hash of every parent domain in one pass
+uint64_t xdp_domain_hash(std::string_view domain);
+
+// Fill maps pinned by xdp_filter.o in pin_dir with filter set and enable fast path
+bool xdp_load_filters(const std::string& pin_dir, const filter_set& rules,
+                      uint16_t port, bool verbose);
+
+// Disable fast path so kernel passes everything to userspace again
+void xdp_disable(const std::string& pin_dir);
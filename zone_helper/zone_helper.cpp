@@ -0,0 +1,190 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <arpa/inet.h>
+
+#include "qtype.hpp"
+#include "qclass.hpp"
+#include "rcode.hpp"
+#include "sinkhole_helper.hpp"
+#include "zone_helper.hpp"
+
+static std::string zone_key(std::string name, uint16_t qtype) {
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    name.push_back(static_cast<char>(qtype >> 8));
+    name.push_back(static_cast<char>(qtype & 0xFF));
+    return name;
+}
+
+// Lowercase name without trailing dot, empty if it is not valid domain name
+static std::string normalize_name(std::string name) {
+    if (!name.empty() && name.back() == '.') name.pop_back();
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name.empty() || name.size() > 253) return "";
+
+    size_t start = 0;
+    while (true) {
+        size_t dot = name.find('.', start);
+        size_t end = (dot == std::string::npos) ? name.size() : dot;
+        if (end == start || end - start > 63) return "";
+        for (size_t pos = start; pos < end; ++pos) {
+            if (!(std::isalnum(static_cast<unsigned char>(name[pos])) || name[pos] == '-' || name[pos] == '_'))
+                return "";
+        }
+        if (dot == std::string::npos) return name;
+        start = dot + 1;
+    }
+}
+
+static bool is_number(const std::string& token) {
+    return !token.empty() && token.size() <= 10 &&
+           std::all_of(token.begin(), token.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); });
+}
+
+// Append A or AAAA record with address in text form, false if address does not parse
+static bool add_record(std::vector<uint8_t>& records, uint16_t qtype, uint32_t ttl, const std::string& address) {
+    uint8_t rdata[16];
+    size_t rdlength = (qtype == QTYPE_A) ? 4 : 16;
+    if (inet_pton(qtype == QTYPE_A ? AF_INET : AF_INET6, address.c_str(), rdata) != 1)
+        return false;
+
+    size_t offset = records.size();
+    records.resize(offset + SINKHOLE_RR_HEADER + rdlength);
+    write_rr_header(&records[offset], qtype, ttl, rdlength);
+    memcpy(&records[offset + SINKHOLE_RR_HEADER], rdata, rdlength);
+    return true;
+}
+
+local_zone load_local_zone(const std::string& filename, bool verbose) {
+    local_zone zone;
+    std::ifstream file(filename);
+
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Cannot open file '" << filename << "'\n";
+        return zone;
+    }
+
+    // Records grouped by name and type first, then copied into hash map
+    std::map<std::string, std::map<uint16_t, local_answer>> names;
+    std::string line;
+    size_t lineno = 0;
+    size_t records = 0;
+
+    while (std::getline(file, line)) {
+        lineno++;
+
+        std::string content = line.substr(0, line.find_first_of("#;"));
+        std::istringstream stream(content);
+        std::vector<std::string> tokens;
+        for (std::string token; stream >> token;) tokens.push_back(token);
+        if (tokens.empty()) continue;
+
+        bool valid = true;
+        in6_addr probe;
+
+        if (inet_pton(AF_INET, tokens[0].c_str(), &probe) == 1 || inet_pton(AF_INET6, tokens[0].c_str(), &probe) == 1) {
+            // Hosts syntax: address followed by names
+            uint16_t qtype = tokens[0].find(':') == std::string::npos ? QTYPE_A : QTYPE_AAAA;
+            valid = tokens.size() >= 2;
+            for (size_t i = 1; valid && i < tokens.size(); ++i) {
+                std::string name = normalize_name(tokens[i]);
+                if (name.empty()) { valid = false; break; }
+                local_answer& answer = names[name][qtype];
+                add_record(answer.records, qtype, LOCAL_DEFAULT_TTL, tokens[0]);
+                answer.count++;
+                records++;
+            }
+        } else {
+            // Zone syntax: name [ttl] [IN] type address
+            std::string name = normalize_name(tokens[0]);
+            size_t pos = 1;
+            uint32_t ttl = LOCAL_DEFAULT_TTL;
+            if (pos < tokens.size() && is_number(tokens[pos])) ttl = std::min(std::stoul(tokens[pos++]), 0x7FFFFFFFUL);
+            if (pos < tokens.size() && (tokens[pos] == "IN" || tokens[pos] == "in")) pos++;
+
+            uint16_t qtype = 0;
+            if (pos + 2 == tokens.size() && (tokens[pos] == "A" || tokens[pos] == "a")) qtype = QTYPE_A;
+            if (pos + 2 == tokens.size() && (tokens[pos] == "AAAA" || tokens[pos] == "aaaa")) qtype = QTYPE_AAAA;
+
+            std::vector<uint8_t> record;
+            valid = !name.empty() && qtype != 0 && add_record(record, qtype, ttl, tokens[pos + 1]);
+            if (valid) {
+                local_answer& answer = names[name][qtype];
+                answer.records.insert(answer.records.end(), record.begin(), record.end());
+                answer.count++;
+                records++;
+            }
+        }
+
+        if (!valid) {
+            std::cerr << "WARNING: Invalid local record on line " << lineno << ": '" << line << "'\n";
+        }
+    }
+
+    for (auto& [name, types] : names) {
+        for (auto& [qtype, answer] : types) {
+            zone.emplace(zone_key(name, qtype), std::move(answer));
+        }
+        // Local names never go upstream, other types get NODATA with SOA for negative caching
+        local_answer nodata;
+        nodata.authority = 1;
+        nodata.records.resize(SINKHOLE_SOA_LENGTH);
+        write_soa_record(nodata.records.data(), LOCAL_DEFAULT_TTL);
+        zone.emplace(zone_key(name, 0), std::move(nodata));
+    }
+
+    if (verbose) {
+        std::cout << "Loaded " << records << " local records for " << names.size() << " names\n";
+        std::cout << "==========================================\n";
+    }
+
+    return zone;
+}
+
+ssize_t build_local_response(const local_zone& zone, const dns_packet& pkt, const dns_query& query, uint8_t* response) {
+    if (zone.empty() || query.qclass != QCLASS_IN || query.qdcount != 1)
+        return -1;
+    if (query.question_end < DNS_HEADER_LENGTH || query.question_end > pkt.length)
+        return -1;
+
+    auto match = zone.find(zone_key(query.qname, query.qtype));
+    if (match == zone.end()) match = zone.find(zone_key(query.qname, 0));
+    if (match == zone.end()) return -1;
+
+    const local_answer& answer = match->second;
+    size_t length = answer.records.size();
+    uint16_t count = answer.count;
+    bool truncated = false;
+    // NODATA always fits, question takes at most 271 bytes
+    if (answer.count && query.question_end + length > BUFFER_SIZE) {
+        // Records of one answer share type and size, keep whole ones that fit
+        size_t record_size = length / answer.count;
+        count = (BUFFER_SIZE - query.question_end) / record_size;
+        length = count * record_size;
+        truncated = true;
+    }
+
+    // Header and question copied from query, any additional records (EDNS) dropped
+    memcpy(response, pkt.data, query.question_end);
+    if (length) memcpy(response + query.question_end, answer.records.data(), length);
+
+    // QR = 1 and AA = 1, TC if truncated, keep only opcode and RD, RA = 1, NOERROR
+    response[2] = (response[2] & 0x79) | 0x84 | (truncated ? 0x02 : 0);
+    response[3] = 0x80 | RCODE_NO_ERROR;
+    // QDCOUNT = 1, ANCOUNT = count, NSCOUNT = authority, ARCOUNT = 0
+    response[4] = 0; response[5] = 1;
+    response[6] = count >> 8; response[7] = count & 0xFF;
+    response[8] = answer.authority >> 8; response[9] = answer.authority & 0xFF;
+    response[10] = response[11] = 0;
+
+    return query.question_end + length;
+}
@@ -0,0 +1,33 @@
+/**
+ * Project ISA25 Filter Resolver
+ * Author: Adam Havlík (xhavli59)
+ * Date: 17.11.2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "dns_structures.hpp"
+
+constexpr uint32_t LOCAL_DEFAULT_TTL = 300; // TTL of hosts entries and zone lines without TTL
+
+// Answer or authority section prebuilt in wire format, owner names compressed to the question name
+struct local_answer {
+    uint16_t count = 0;           // ANCOUNT, 0 = name exists without records of this type (NODATA)
+    uint16_t authority = 0;       // NSCOUNT, 1 for NODATA carrying SOA
+    std::vector<uint8_t> records;
+};
+
+// Lowercase name followed by 2 bytes QTYPE -> answer, QTYPE 0 holds NODATA answer of the name
+using local_zone = std::unordered_map<std::string, local_answer>;
+
+// Load hosts file or zone lines "name [ttl] [IN] A|AAAA address"
+local_zone load_local_zone(const std::string& filename, bool verbose);
+
+// Build answer for query of local name into response, returns its length or -1 if name is not local.
+// Answer not fitting into UDP message carries records that fit and TC flag.
+ssize_t build_local_response(const local_zone& zone, const dns_packet& pkt, const dns_query& query, uint8_t* response);